@@ -0,0 +1,260 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "AutoSim.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+#include <frc/simulation/SimDeviceSim.h>
+#include <frc/simulation/SimHooks.h>
+#include <hal/SimDevice.h>
+
+#include "Robot.hpp"
+
+namespace autosim {
+
+namespace {
+
+// Talon IDs of the leaders of the drivetrain's and elevator's gearboxes, which
+// also have their encoders
+constexpr int kLeftDriveID = 4;
+constexpr int kRightDriveID = 5;
+constexpr int kLiftID = 7;
+
+// Returns a simulated device's value, or throws if the device or value doesn't
+// exist, which means the robot code and the simulation are out of sync
+template <typename T>
+T CheckValue(T value, const std::string& device, const char* name) {
+    if (!value) {
+        throw std::runtime_error{
+            fmt::format("{} has no simulated value '{}'", device, name)};
+    }
+    return value;
+}
+
+/**
+ * A mechanism driven by a TalonSRXGroup whose position is measured by a
+ * CANEncoder on the group's leader.
+ */
+class Mechanism {
+public:
+    /**
+     * Constructs a Mechanism.
+     *
+     * @param talonID ID of the Talon leading the group.
+     * @param plant   Model of the mechanism.
+     * @param noise   Standard deviation of the encoder noise.
+     * @param rng     Source of the encoder noise.
+     */
+    Mechanism(int talonID, const FirstOrderPlant& plant, double noise,
+              std::mt19937& rng)
+        : m_output{GetValue(fmt::format("TalonSRXGroup[{}]", talonID),
+                            "output")},
+          m_distance{
+              GetValue(fmt::format("CANEncoder[{}]", talonID), "distance")},
+          m_rate{GetValue(fmt::format("CANEncoder[{}]", talonID), "rate")},
+          m_plant{plant},
+          m_noise{0.0, noise},
+          m_rng{rng} {}
+
+    /**
+     * Advances the mechanism by dt with the group's current output, then sets
+     * the encoder's readings.
+     */
+    void Update(units::second_t dt) {
+        m_plant.Update(m_output.Get(), dt);
+
+        // The robot code may have reset the encoder since the last update
+        if (m_distance.Get() != m_lastReading) {
+            m_encoderPosition = m_distance.Get();
+        }
+
+        // The encoder moves by the change in position so a reset sticks. The
+        // noise is only added to the reading so it doesn't accumulate.
+        m_encoderPosition += m_plant.GetPosition() - m_lastPosition;
+        m_lastPosition = m_plant.GetPosition();
+        m_lastReading = m_encoderPosition + m_noise(m_rng);
+        m_distance.Set(m_lastReading);
+        m_rate.Set(m_plant.GetSpeed());
+    }
+
+    // Returns the position in distance units
+    double GetPosition() const { return m_plant.GetPosition(); }
+
+private:
+    hal::SimDouble m_output;
+    hal::SimDouble m_distance;
+    hal::SimDouble m_rate;
+
+    FirstOrderPlant m_plant;
+
+    std::normal_distribution<double> m_noise;
+    std::mt19937& m_rng;
+
+    double m_lastPosition = 0.0;
+
+    // The encoder's position without noise, and what it last read
+    double m_encoderPosition = 0.0;
+    double m_lastReading = 0.0;
+
+    static hal::SimDouble GetValue(const std::string& device,
+                                   const char* name) {
+        return CheckValue(
+            frc::sim::SimDeviceSim{device.c_str()}.GetDouble(name), device,
+            name);
+    }
+};
+
+}  // namespace
+
+Result Run(wpi::StringRef mode, const PlantParameters& parameters,
+           units::second_t length) {
+    Result result;
+    result.mode = mode.str();
+
+    // A new Robot each run so state like the elevator's goal doesn't carry
+    // over from the last one
+    Robot robot;
+
+    auto& chooser = robot.GetAutonomousChooser();
+    const auto& names = chooser.GetAutonomousNames();
+    if (std::find(names.begin(), names.end(), mode) == names.end()) {
+        throw std::invalid_argument{
+            fmt::format("No autonomous mode named '{}'", mode.str())};
+    }
+    chooser.SelectAutonomous(mode);
+
+    std::mt19937 rng{parameters.noiseSeed};
+    Mechanism leftDrive{kLeftDriveID, MakeLeftDrivePlant(parameters),
+                        parameters.encoderNoise, rng};
+    Mechanism rightDrive{kRightDriveID, MakeRightDrivePlant(parameters),
+                         parameters.encoderNoise, rng};
+    Mechanism lift{kLiftID, MakeLiftPlant(parameters), parameters.encoderNoise,
+                   rng};
+
+    // The elevator's limit switch closes at the bottom of its travel
+    std::string limitSwitchName = fmt::format("CANDigitalInput[{}]", kLiftID);
+    auto limitSwitch = CheckValue(
+        frc::sim::SimDeviceSim{limitSwitchName.c_str()}.GetBoolean("value"),
+        limitSwitchName, "value");
+    limitSwitch.Set(true);
+
+    auto wallStart = std::chrono::steady_clock::now();
+
+    robot.AutonomousInit();
+
+    units::second_t time = 0_s;
+    while (time < length) {
+        if (!result.finished && !chooser.IsAutonomousRunning()) {
+            result.finished = true;
+            result.finishTime = time;
+        }
+
+        frc::sim::StepTiming(kDt);
+        time += kDt;
+
+        leftDrive.Update(kDt);
+        rightDrive.Update(kDt);
+        lift.Update(kDt);
+        limitSwitch.Set(lift.GetPosition() <=
+                        Elevator::kGroundHeight.to<double>());
+
+        robot.AutonomousPeriodic();
+    }
+
+    result.leftDistance = robot.drivetrain.GetLeftDistance();
+    result.rightDistance = robot.drivetrain.GetRightDistance();
+    result.elevatorHeight = robot.elevator.GetHeight();
+
+    robot.DisabledInit();
+
+    result.wallTime = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - wallStart)
+                          .count() *
+                      1_s;
+
+    if (!result.finished) {
+        result.finishTime = time;
+    }
+
+    return result;
+}
+
+std::vector<StackResult> RunAutoStackVariants(
+    const std::vector<PlantParameters>& variants) {
+    std::vector<StackResult> results;
+
+    Robot robot;
+    auto& elevator = robot.elevator;
+
+    std::string limitSwitchName = fmt::format("CANDigitalInput[{}]", kLiftID);
+    auto limitSwitch = CheckValue(
+        frc::sim::SimDeviceSim{limitSwitchName.c_str()}.GetBoolean("value"),
+        limitSwitchName, "value");
+
+    // Runs one tick of the elevator like the robot's periodic functions do
+    auto tick = [&] {
+        elevator.SampleSensors();
+        elevator.UpdateState();
+        elevator.FlushOutputs();
+    };
+
+    // Puts the lift at the bottom and lets the elevator see the limit switch
+    // close, so it doesn't rezero the lift and reset its goal mid-stack
+    auto settle = [&] {
+        elevator.ResetEncoders();
+        limitSwitch.Set(true);
+        tick();
+    };
+
+    settle();
+    elevator.StackTotes();
+    tick();
+    auto checkpoint = elevator.SaveAutoStack();
+
+    for (const auto& parameters : variants) {
+        settle();
+
+        std::mt19937 rng{parameters.noiseSeed};
+        Mechanism lift{kLiftID, MakeLiftPlant(parameters),
+                       parameters.encoderNoise, rng};
+        elevator.RestoreAutoStack(checkpoint);
+
+        StackResult result;
+        while (result.time < kMaxStackLength && elevator.IsStacking()) {
+            frc::sim::StepTiming(kDt);
+            result.time += kDt;
+
+            lift.Update(kDt);
+            limitSwitch.Set(lift.GetPosition() <=
+                            Elevator::kGroundHeight.to<double>());
+            tick();
+        }
+        result.finished = !elevator.IsStacking();
+        results.emplace_back(result);
+    }
+
+    return results;
+}
+
+FirstOrderPlant MakeLeftDrivePlant(const PlantParameters& parameters) {
+    return FirstOrderPlant{parameters.leftDriveFreeSpeed,
+                           parameters.timeConstant};
+}
+
+FirstOrderPlant MakeRightDrivePlant(const PlantParameters& parameters) {
+    return FirstOrderPlant{parameters.rightDriveFreeSpeed,
+                           parameters.timeConstant};
+}
+
+FirstOrderPlant MakeLiftPlant(const PlantParameters& parameters) {
+    return FirstOrderPlant{parameters.liftFreeSpeed, parameters.timeConstant,
+                           Elevator::kGroundHeight.to<double>(),
+                           Elevator::kMaxHeight.to<double>()};
+}
+
+}  // namespace autosim
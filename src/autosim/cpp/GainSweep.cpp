@@ -0,0 +1,255 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "GainSweep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+#include <frc/controller/ProfiledPIDController.h>
+#include <units/math.h>
+
+#include "AutoSim.hpp"
+#include "FirstOrderPlant.hpp"
+#include "MonteCarlo.hpp"
+#include "subsystems/Drivetrain.hpp"
+#include "subsystems/Elevator.hpp"
+
+namespace autosim {
+
+namespace {
+
+// Number of randomized plants each combination is run against besides the
+// nominal one
+constexpr size_t kRandomPlants = 7;
+
+constexpr double kBatteryVoltage = 12.0;
+
+// A move from rest at the start position to the goal, in inches
+struct Move {
+    double start;
+    double goal;
+};
+
+// The grid of gains to sweep and the moves to score them on
+struct SweepSpec {
+    std::vector<double> kp;
+    std::vector<double> ki;
+    std::vector<double> kd;
+
+    // The constraints are swept as multiples of the current ones
+    Gains current;
+    std::vector<double> maxVScales;
+    std::vector<double> maxAScales;
+
+    // Gains in the code, which are scored along with the grid
+    std::vector<std::pair<std::string, Gains>> baselines;
+
+    std::vector<Move> moves;
+
+    // How close to the goal a move has to stay to be settled, in inches
+    double tolerance;
+
+    // How long each move is simulated for
+    units::second_t length;
+};
+
+SweepSpec MakeSpec(TunedSubsystem subsystem) {
+    SweepSpec spec;
+    spec.maxVScales = {0.75, 1.0, 1.25};
+    spec.maxAScales = {0.75, 1.0, 1.5, 2.0};
+
+    if (subsystem == TunedSubsystem::kDrivetrain) {
+        spec.kp = {1.0, 2.0, 3.0, 5.0, 8.0, 12.0, 16.0};
+        spec.ki = {0.0, 0.5};
+        spec.kd = {0.0, 0.5, 1.0, 2.0, 3.0, 5.0};
+        spec.current = {0.0, 0.0, 0.0, Drivetrain::kMaxV, Drivetrain::kMaxA};
+        spec.baselines = {
+            {"Drivetrain left", {5.0, 0.0, 2.0, spec.current.maxV,
+                                 spec.current.maxA}},
+            {"Drivetrain right", {8.0, 0.0, 3.0, spec.current.maxV,
+                                  spec.current.maxA}}};
+        spec.moves = {{0.0, 24.0}, {0.0, 144.0}};
+        spec.tolerance = 1.0;
+        spec.length = 8_s;
+    } else {
+        spec.kp = {0.05, 0.1, 0.2, 0.3, 0.5, 1.0, 2.0, 3.0};
+        spec.ki = {0.0, 0.02};
+        spec.kd = {0.0, 0.005, 0.01, 0.02, 0.05};
+        spec.current = {0.0, 0.0, 0.0, Elevator::kMaxVUp, Elevator::kMaxAUp};
+        spec.baselines = {
+            {"Elevator", {3.0, 0.0, 0.0, spec.current.maxV,
+                          spec.current.maxA}}};
+        spec.moves = {
+            {Elevator::kGroundHeight.to<double>(),
+             Elevator::kToteHeight3.to<double>()},
+            {Elevator::kToteHeight3.to<double>(),
+             Elevator::kToteHeight1.to<double>()},
+            {Elevator::kGroundHeight.to<double>(),
+             Elevator::kStepHeight.to<double>()}};
+        spec.tolerance = 0.5;
+        spec.length = 4_s;
+    }
+
+    return spec;
+}
+
+std::vector<FirstOrderPlant> MakePlants(TunedSubsystem subsystem,
+                                        uint32_t seed) {
+    std::vector<PlantParameters> parameters{PlantParameters{}};
+    for (size_t trial = 0; trial < kRandomPlants; ++trial) {
+        parameters.emplace_back(RandomizePlant(seed, trial));
+    }
+
+    std::vector<FirstOrderPlant> plants;
+    for (const auto& plant : parameters) {
+        if (subsystem == TunedSubsystem::kDrivetrain) {
+            plants.emplace_back(MakeLeftDrivePlant(plant));
+            plants.emplace_back(MakeRightDrivePlant(plant));
+        } else {
+            plants.emplace_back(MakeLiftPlant(plant));
+        }
+    }
+    return plants;
+}
+
+/**
+ * Runs each move on each plant with the gains and scores the results.
+ *
+ * The controller is reused between calls, since constructing one isn't
+ * thread-safe.
+ */
+template <typename Distance>
+GainScore Evaluate(frc::ProfiledPIDController<Distance>& controller,
+                   const Gains& gains, const SweepSpec& spec,
+                   const std::vector<FirstOrderPlant>& plants) {
+    GainScore result;
+    result.gains = gains;
+    result.settled = true;
+
+    controller.SetPID(gains.kp, gains.ki, gains.kd);
+    controller.SetConstraints({gains.maxV, gains.maxA});
+
+    int ticks = static_cast<int>(std::round((spec.length / kDt).to<double>()));
+    double voltageSum = 0.0;
+    size_t voltageCount = 0;
+    double overshoot = 0.0;
+
+    for (auto plant : plants) {
+        for (const auto& move : spec.moves) {
+            plant.Reset(move.start);
+            controller.Reset(units::inch_t{move.start});
+            controller.SetGoal(units::inch_t{move.goal});
+
+            double direction = move.goal > move.start ? 1.0 : -1.0;
+            int lastOutside = 0;
+            double error = 0.0;
+            for (int tick = 1; tick <= ticks; ++tick) {
+                double output = std::clamp(
+                    controller.Calculate(units::inch_t{plant.GetPosition()}),
+                    -1.0, 1.0);
+                plant.Update(output, kDt);
+
+                voltageSum += std::abs(output) * kBatteryVoltage;
+                ++voltageCount;
+
+                error = plant.GetPosition() - move.goal;
+                overshoot = std::max(overshoot, error * direction);
+                if (std::abs(error) > spec.tolerance) {
+                    lastOutside = tick;
+                }
+            }
+
+            if (std::abs(error) > spec.tolerance) {
+                result.settled = false;
+            }
+            result.settlingTime =
+                units::math::max(result.settlingTime, lastOutside * kDt);
+        }
+    }
+
+    result.overshoot = units::inch_t{overshoot};
+    result.meanVoltage = voltageSum / voltageCount;
+    result.score = result.settlingTime.to<double>() + 0.1 * overshoot +
+                   0.05 * result.meanVoltage + (result.settled ? 0.0 : 10.0);
+
+    return result;
+}
+
+template <typename Distance>
+void Sweep(std::vector<GainScore>& results, const SweepSpec& spec,
+           const std::vector<FirstOrderPlant>& plants, unsigned int threads) {
+    // Constructed up front since the constructor isn't thread-safe
+    std::vector<std::unique_ptr<frc::ProfiledPIDController<Distance>>>
+        controllers;
+    for (unsigned int i = 0; i < threads; ++i) {
+        controllers.emplace_back(
+            std::make_unique<frc::ProfiledPIDController<Distance>>(
+                0.0, 0.0, 0.0,
+                typename frc::TrapezoidProfile<Distance>::Constraints{
+                    spec.current.maxV, spec.current.maxA}));
+    }
+
+    // Each thread claims the next unscored result until there are none left
+    std::atomic<size_t> next{0};
+    auto work = [&](frc::ProfiledPIDController<Distance>& controller) {
+        for (size_t i = next++; i < results.size(); i = next++) {
+            auto label = std::move(results[i].label);
+            results[i] = Evaluate(controller, results[i].gains, spec, plants);
+            results[i].label = std::move(label);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; ++i) {
+        pool.emplace_back(work, std::ref(*controllers[i]));
+    }
+    work(*controllers[0]);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+}  // namespace
+
+std::vector<GainScore> SweepGains(TunedSubsystem subsystem,
+                                  unsigned int threads, uint32_t seed) {
+    auto spec = MakeSpec(subsystem);
+    auto plants = MakePlants(subsystem, seed);
+    threads = std::max(threads, 1u);
+
+    std::vector<GainScore> results;
+    for (const auto& [label, gains] : spec.baselines) {
+        results.emplace_back().gains = gains;
+        results.back().label = label;
+    }
+    for (double kp : spec.kp) {
+        for (double ki : spec.ki) {
+            for (double kd : spec.kd) {
+                for (double maxVScale : spec.maxVScales) {
+                    for (double maxAScale : spec.maxAScales) {
+                        results.emplace_back().gains = {
+                            kp, ki, kd, spec.current.maxV * maxVScale,
+                            spec.current.maxA * maxAScale};
+                    }
+                }
+            }
+        }
+    }
+
+    if (subsystem == TunedSubsystem::kDrivetrain) {
+        Sweep<units::feet>(results, spec, plants, threads);
+    } else {
+        Sweep<units::inches>(results, spec, plants, threads);
+    }
+
+    std::stable_sort(results.begin(), results.end(),
+                     [](const auto& lhs, const auto& rhs) {
+                         return lhs.score < rhs.score;
+                     });
+    return results;
+}
+
+}  // namespace autosim
@@ -0,0 +1,255 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+#include <frc/simulation/SimHooks.h>
+#include <hal/HAL.h>
+
+#include "AutoSim.hpp"
+#include "GainSweep.hpp"
+#include "MonteCarlo.hpp"
+#include "Robot.hpp"
+
+namespace {
+
+constexpr const char* kUsage =
+    "Usage: {0} [--trials <count>] [--seed <seed>] [mode...]\n"
+    "       {0} --tune drivetrain|elevator [--seed <seed>]\n"
+    "       {0} --stack <variants> [--seed <seed>]\n"
+    "\n"
+    "Runs the named autonomous modes, or all of them, in simulation.\n"
+    "With --trials, runs each mode that many times with randomized plant\n"
+    "parameters in parallel, and prints statistics of the results.\n"
+    "\n"
+    "With --tune, sweeps the subsystem's controller gains and motion profile\n"
+    "constraints against simulated plants, and prints the best ones.\n"
+    "\n"
+    "With --stack, forks that many variants of the elevator's auto-stack with\n"
+    "randomized plant parameters from one checkpoint, and prints statistics\n"
+    "of how long they took.\n";
+
+// Number of the best gains PrintGains() prints
+constexpr size_t kPrintedGains = 20;
+
+// Parses an unsigned integer argument, or exits with the usage
+unsigned long ParseCount(const char* program, const char* arg) {
+    char* end = nullptr;
+    unsigned long value = strtoul(arg, &end, 10);
+    if (end == arg || *end != '\0') {
+        fmt::print(stderr, "'{}' isn't a number\n\n", arg);
+        fmt::print(stderr, kUsage, program);
+        exit(1);
+    }
+    return value;
+}
+
+void PrintResults(const std::vector<autosim::Result>& results) {
+    fmt::print("\n{:<24} {:>9} {:>10} {:>10} {:>10} {:>9}\n", "Mode",
+               "Done (s)", "Left (in)", "Right (in)", "Lift (in)", "Wall (ms)");
+    for (const auto& result : results) {
+        fmt::print("{:<24} {:>9} {:>10.2f} {:>10.2f} {:>10.2f} {:>9.1f}\n",
+                   result.mode,
+                   result.finished
+                       ? fmt::format("{:.2f}", result.finishTime.to<double>())
+                       : std::string{"-"},
+                   result.leftDistance.to<double>(),
+                   result.rightDistance.to<double>(),
+                   result.elevatorHeight.to<double>(),
+                   result.wallTime.to<double>() * 1000.0);
+    }
+}
+
+void PrintSummary(const autosim::ModeSummary& summary) {
+    fmt::print("\n{}: {} trials, {:.1f}% finished\n", summary.mode,
+               summary.trials,
+               summary.trials == 0
+                   ? 0.0
+                   : 100.0 * summary.finished / summary.trials);
+    fmt::print("  {:<12} {:>9} {:>9} {:>9} {:>9} {:>9}\n", "", "Mean",
+               "Stddev", "5%", "Median", "95%");
+
+    auto printRow = [](const char* name, const autosim::Distribution& d) {
+        fmt::print("  {:<12} {:>9.2f} {:>9.2f} {:>9.2f} {:>9.2f} {:>9.2f}\n",
+                   name, d.mean, d.stddev, d.p5, d.median, d.p95);
+    };
+    printRow("Done (s)", summary.finishTime);
+    printRow("Left (in)", summary.leftDistance);
+    printRow("Right (in)", summary.rightDistance);
+    printRow("Lift (in)", summary.elevatorHeight);
+}
+
+void PrintGains(autosim::TunedSubsystem subsystem,
+                const std::vector<autosim::GainScore>& scores) {
+    fmt::print("\nGains are per {}. Velocities and accelerations are in "
+               "inches.\n",
+               subsystem == autosim::TunedSubsystem::kDrivetrain ? "foot"
+                                                                  : "inch");
+    fmt::print(
+        "{:>5} {:>7} {:>7} {:>7} {:>8} {:>8} {:>7} {:>10} {:>10} {:>8}  {}\n",
+        "Rank", "Kp", "Ki", "Kd", "MaxV", "MaxA", "Score", "Settle (s)",
+        "Overshoot", "Mean (V)", "In code");
+
+    // The best gains, then the ones in the code wherever they ranked
+    for (size_t i = 0; i < scores.size(); ++i) {
+        const auto& score = scores[i];
+        if (i >= kPrintedGains && score.label.empty()) {
+            continue;
+        }
+        fmt::print(
+            "{:>5} {:>7.3g} {:>7.3g} {:>7.3g} {:>8.2f} {:>8.2f} {:>7.3f} "
+            "{:>10} {:>10.2f} {:>8.2f}  {}\n",
+            i + 1, score.gains.kp, score.gains.ki, score.gains.kd,
+            units::inch_t{score.gains.maxV * 1_s}.to<double>(),
+            units::inch_t{score.gains.maxA * 1_s * 1_s}.to<double>(),
+            score.score,
+            score.settled
+                ? fmt::format("{:.2f}", score.settlingTime.to<double>())
+                : std::string{"-"},
+            score.overshoot.to<double>(), score.meanVoltage, score.label);
+    }
+}
+
+void PrintStackResults(const std::vector<autosim::StackResult>& results) {
+    std::vector<double> times;
+    for (const auto& result : results) {
+        if (result.finished) {
+            times.emplace_back(result.time.to<double>());
+        }
+    }
+
+    fmt::print("\nAuto-stack: {} variants, {} finished\n", results.size(),
+               times.size());
+    auto d = autosim::Distribution::Of(std::move(times));
+    fmt::print("  {:<12} {:>9} {:>9} {:>9} {:>9} {:>9}\n", "", "Mean",
+               "Stddev", "5%", "Median", "95%");
+    fmt::print("  {:<12} {:>9.2f} {:>9.2f} {:>9.2f} {:>9.2f} {:>9.2f}\n",
+               "Done (s)", d.mean, d.stddev, d.p5, d.median, d.p95);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    HAL_Initialize(500, 0);
+
+    // Simulated time only advances when the simulation steps it
+    frc::sim::PauseTiming();
+
+    // A worker process started by autosim::RunMonteCarlo()
+    if (argc == 6 && std::string{argv[1]} == "--worker") {
+        autosim::RunWorker(argv[2], ParseCount(argv[0], argv[3]),
+                           ParseCount(argv[0], argv[4]),
+                           ParseCount(argv[0], argv[5]));
+        return 0;
+    }
+
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Gain sweeps don't run the robot code, so they're handled first
+    if (argc >= 3 && std::string{argv[1]} == "--tune") {
+        std::string name = argv[2];
+        autosim::TunedSubsystem subsystem;
+        if (name == "drivetrain") {
+            subsystem = autosim::TunedSubsystem::kDrivetrain;
+        } else if (name == "elevator") {
+            subsystem = autosim::TunedSubsystem::kElevator;
+        } else {
+            fmt::print(stderr, kUsage, argv[0]);
+            return 1;
+        }
+
+        uint32_t seed = 0;
+        if (argc == 5 && std::string{argv[3]} == "--seed") {
+            seed = ParseCount(argv[0], argv[4]);
+        } else if (argc != 3) {
+            fmt::print(stderr, kUsage, argv[0]);
+            return 1;
+        }
+
+        PrintGains(subsystem, autosim::SweepGains(subsystem, threads, seed));
+        return 0;
+    }
+
+    // Auto-stack variants only run the elevator
+    if (argc >= 3 && std::string{argv[1]} == "--stack") {
+        size_t count = ParseCount(argv[0], argv[2]);
+
+        uint32_t seed = 0;
+        if (argc == 5 && std::string{argv[3]} == "--seed") {
+            seed = ParseCount(argv[0], argv[4]);
+        } else if (argc != 3) {
+            fmt::print(stderr, kUsage, argv[0]);
+            return 1;
+        }
+
+        std::vector<autosim::PlantParameters> variants;
+        for (size_t i = 0; i < count; ++i) {
+            variants.emplace_back(autosim::RandomizePlant(seed, i));
+        }
+        PrintStackResults(autosim::RunAutoStackVariants(variants));
+        return 0;
+    }
+
+    std::vector<std::string> names;
+    {
+        Robot robot;
+        names = robot.GetAutonomousChooser().GetAutonomousNames();
+    }
+
+    size_t trials = 0;
+    uint32_t seed = 0;
+    std::vector<std::string> modes;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--trials" || arg == "--seed") && i + 1 < argc) {
+            auto value = ParseCount(argv[0], argv[++i]);
+            if (arg == "--trials") {
+                trials = value;
+            } else {
+                seed = value;
+            }
+        } else if (arg.compare(0, 2, "--") == 0) {
+            fmt::print(stderr, kUsage, argv[0]);
+            return 1;
+        } else if (std::find(names.begin(), names.end(), arg) == names.end()) {
+            fmt::print(stderr, "No autonomous mode named '{}'. Modes are:\n",
+                       arg);
+            for (const auto& name : names) {
+                fmt::print(stderr, "  {}\n", name);
+            }
+            return 1;
+        } else {
+            modes.emplace_back(arg);
+        }
+    }
+    if (modes.empty()) {
+        modes = names;
+    }
+
+    if (trials == 0) {
+        std::vector<autosim::Result> results;
+        for (const auto& mode : modes) {
+            results.emplace_back(autosim::Run(mode));
+        }
+        PrintResults(results);
+    } else {
+        for (const auto& mode : modes) {
+            try {
+                PrintSummary(autosim::RunMonteCarlo(argv[0], mode, trials,
+                                                    seed, threads));
+            } catch (const std::invalid_argument& e) {
+                fmt::print(stderr, "Skipped {}: {}\n", mode, e.what());
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "MonteCarlo.hpp"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/core.h>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace autosim {
+
+namespace {
+
+// One trial's result as a worker reports it
+struct TrialResult {
+    bool finished = false;
+    double finishTime = 0.0;
+    double leftDistance = 0.0;
+    double rightDistance = 0.0;
+    double elevatorHeight = 0.0;
+};
+
+// Returns the sample at the percentile of sorted samples
+double Percentile(const std::vector<double>& sorted, double percentile) {
+    return sorted[static_cast<size_t>(
+        std::round(percentile * static_cast<double>(sorted.size() - 1)))];
+}
+
+/**
+ * Starts a worker process, then collects its results until it exits.
+ *
+ * @return An error message, or an empty string if the worker succeeded.
+ */
+std::string CollectWorker(const std::string& command, size_t count,
+                          std::vector<TrialResult>& results) {
+    FILE* pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) {
+        return fmt::format("Failed to start '{}'", command);
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), pipe) != nullptr) {
+        TrialResult result;
+        int finished = 0;
+        if (sscanf(line, "result %d %lf %lf %lf %lf", &finished,
+                   &result.finishTime, &result.leftDistance,
+                   &result.rightDistance, &result.elevatorHeight) == 5) {
+            result.finished = finished != 0;
+            results.emplace_back(result);
+        }
+    }
+
+    int status = pclose(pipe);
+    if (status != 0) {
+        return fmt::format("'{}' exited with status {}", command, status);
+    }
+    if (results.size() != count) {
+        return fmt::format("'{}' reported {} of {} trials", command,
+                           results.size(), count);
+    }
+    return "";
+}
+
+}  // namespace
+
+Distribution Distribution::Of(std::vector<double> samples) {
+    Distribution distribution;
+    if (samples.empty()) {
+        return distribution;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    distribution.mean = sum / samples.size();
+
+    double squares = 0.0;
+    for (double sample : samples) {
+        squares += (sample - distribution.mean) * (sample - distribution.mean);
+    }
+    distribution.stddev = std::sqrt(squares / samples.size());
+
+    distribution.p5 = Percentile(samples, 0.05);
+    distribution.median = Percentile(samples, 0.5);
+    distribution.p95 = Percentile(samples, 0.95);
+
+    return distribution;
+}
+
+PlantParameters RandomizePlant(uint32_t seed, size_t trial) {
+    uint64_t trial64 = trial;
+    std::seed_seq seq{seed, static_cast<uint32_t>(trial64),
+                      static_cast<uint32_t>(trial64 >> 32)};
+    std::mt19937 rng{seq};
+
+    // Clamped so an extreme sample can't stall or reverse a mechanism
+    auto scale = [&](double stddev) {
+        return std::clamp(std::normal_distribution<double>{1.0, stddev}(rng),
+                          0.5, 1.5);
+    };
+
+    PlantParameters parameters;
+
+    double driveScale = scale(0.08);
+    parameters.leftDriveFreeSpeed *= driveScale * scale(0.03);
+    parameters.rightDriveFreeSpeed *= driveScale * scale(0.03);
+    parameters.liftFreeSpeed *= scale(0.08);
+    parameters.timeConstant = units::second_t{
+        std::uniform_real_distribution<double>{0.07, 0.13}(rng)};
+    parameters.encoderNoise = 0.05;
+    parameters.noiseSeed = rng();
+
+    return parameters;
+}
+
+ModeSummary RunMonteCarlo(const std::string& executable,
+                          const std::string& mode, size_t trials,
+                          uint32_t seed, unsigned int workers) {
+    // The mode is passed to the workers through the shell, so its name is
+    // limited to characters the shell doesn't interpret. Script names come
+    // from file names, which can contain anything.
+    bool safeName =
+        !mode.empty() && std::all_of(mode.begin(), mode.end(), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' ||
+                   c == '-';
+        });
+    if (!safeName) {
+        throw std::invalid_argument{fmt::format(
+            "Mode name '{}' can only contain letters, digits, '_', and '-'",
+            mode)};
+    }
+
+    workers = std::max(1u, std::min<unsigned int>(workers, trials));
+
+    std::vector<std::vector<TrialResult>> results(workers);
+    std::vector<std::string> errors(workers);
+    std::vector<std::thread> threads;
+
+    size_t first = 0;
+    for (unsigned int i = 0; i < workers; ++i) {
+        // Spreads the remainder over the first workers
+        size_t count = trials / workers + (i < trials % workers ? 1 : 0);
+
+        std::string command =
+            fmt::format("\"{}\" --worker \"{}\" {} {} {}", executable, mode,
+                        first, count, seed);
+#ifdef _WIN32
+        // cmd.exe strips the outer quotes if the command starts with one
+        command = "\"" + command + "\"";
+#endif
+
+        threads.emplace_back([&, i, command, count] {
+            errors[i] = CollectWorker(command, count, results[i]);
+        });
+        first += count;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            throw std::runtime_error{error};
+        }
+    }
+
+    ModeSummary summary;
+    summary.mode = mode;
+    summary.trials = trials;
+
+    std::vector<double> finishTimes;
+    std::vector<double> leftDistances;
+    std::vector<double> rightDistances;
+    std::vector<double> elevatorHeights;
+    for (const auto& workerResults : results) {
+        for (const auto& result : workerResults) {
+            if (result.finished) {
+                ++summary.finished;
+                finishTimes.emplace_back(result.finishTime);
+            }
+            leftDistances.emplace_back(result.leftDistance);
+            rightDistances.emplace_back(result.rightDistance);
+            elevatorHeights.emplace_back(result.elevatorHeight);
+        }
+    }
+
+    summary.finishTime = Distribution::Of(std::move(finishTimes));
+    summary.leftDistance = Distribution::Of(std::move(leftDistances));
+    summary.rightDistance = Distribution::Of(std::move(rightDistances));
+    summary.elevatorHeight = Distribution::Of(std::move(elevatorHeights));
+
+    return summary;
+}
+
+void RunWorker(const std::string& mode, size_t first, size_t count,
+               uint32_t seed) {
+    for (size_t trial = first; trial < first + count; ++trial) {
+        auto result = Run(mode, RandomizePlant(seed, trial));
+
+        fmt::print("result {:d} {:.17g} {:.17g} {:.17g} {:.17g}\n",
+                   result.finished ? 1 : 0, result.finishTime.to<double>(),
+                   result.leftDistance.to<double>(),
+                   result.rightDistance.to<double>(),
+                   result.elevatorHeight.to<double>());
+    }
+    fflush(stdout);
+}
+
+}  // namespace autosim
@@ -0,0 +1,130 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <units/length.h>
+#include <units/time.h>
+#include <wpi/StringRef.h>
+
+#include "FirstOrderPlant.hpp"
+
+namespace autosim {
+
+/**
+ * Parameters of the physics models the robot is simulated against.
+ *
+ * Each mechanism's speed approaches its motor output times its free speed with
+ * a first-order lag. That's crude, but enough to close the subsystems'
+ * control loops and exercise the autonomous modes' timing.
+ */
+struct PlantParameters {
+    // Speeds of each side of the drivetrain at full output in inches per
+    // second
+    double leftDriveFreeSpeed = 120.0;
+    double rightDriveFreeSpeed = 120.0;
+
+    // Speed of the elevator at full output in inches per second
+    double liftFreeSpeed = 100.0;
+
+    // Time constant of the lag from motor output to speed
+    units::second_t timeConstant = 100_ms;
+
+    // Standard deviation of the noise added to each encoder reading in inches
+    double encoderNoise = 0.0;
+
+    // Seed for the encoder noise
+    uint32_t noiseSeed = 0;
+};
+
+/**
+ * The outcome of simulating an autonomous mode.
+ */
+struct Result {
+    std::string mode;
+
+    // True if the mode returned before autonomous ended
+    bool finished = false;
+
+    // When the mode returned, or the length of autonomous if it didn't
+    units::second_t finishTime = 0_s;
+
+    // Drivetrain and elevator encoder readings when autonomous ended
+    units::inch_t leftDistance = 0_in;
+    units::inch_t rightDistance = 0_in;
+    units::inch_t elevatorHeight = 0_in;
+
+    // Wall-clock time the simulated autonomous period took
+    units::second_t wallTime = 0_s;
+};
+
+/**
+ * The outcome of simulating one variant of an auto-stack.
+ */
+struct StackResult {
+    // True if the stack finished before kMaxStackLength
+    bool finished = false;
+
+    // How long the stack took from the checkpoint, or kMaxStackLength if it
+    // didn't finish
+    units::second_t time = 0_s;
+};
+
+// The length of autonomous in a match
+constexpr units::second_t kAutonomousLength = 15_s;
+
+// The longest a simulated auto-stack is run for
+constexpr units::second_t kMaxStackLength = 10_s;
+
+// TimedRobot's default period
+constexpr units::second_t kDt = 20_ms;
+
+/**
+ * Runs an autonomous mode on a newly constructed Robot without a driver
+ * station or wall-clock pacing.
+ *
+ * Each tick steps the HAL simulation clock by kDt, updates the physics models
+ * from the motor outputs, then calls Robot::AutonomousPeriodic(), so a whole
+ * autonomous period runs as fast as the CPU allows. The simulation clock must
+ * have been paused with frc::sim::PauseTiming() first, and no other Robot may
+ * exist during the run since they'd share the same simulated devices.
+ *
+ * @param mode       Name of the autonomous mode.
+ * @param parameters Parameters of the physics models.
+ * @param length     How long to run autonomous for.
+ * @throws std::invalid_argument if there's no autonomous mode with the name.
+ */
+Result Run(wpi::StringRef mode, const PlantParameters& parameters = {},
+           units::second_t length = kAutonomousLength);
+
+/**
+ * Runs the elevator's auto-stack once for each set of plant parameters.
+ *
+ * The stack is started from the ground once and checkpointed with
+ * Elevator::SaveAutoStack(). Each variant puts the lift back at the bottom,
+ * restores the checkpoint, and runs the stack to completion against its own
+ * lift model, so variants don't construct a Robot or replay the start of the
+ * stack. The requirements are the same as Run()'s.
+ *
+ * @param variants Parameters of the physics models for each variant.
+ */
+std::vector<StackResult> RunAutoStackVariants(
+    const std::vector<PlantParameters>& variants);
+
+/**
+ * Returns models of the left and right sides of the drivetrain in inches.
+ */
+FirstOrderPlant MakeLeftDrivePlant(const PlantParameters& parameters);
+FirstOrderPlant MakeRightDrivePlant(const PlantParameters& parameters);
+
+/**
+ * Returns a model of the elevator in inches, between its lowest and highest
+ * heights.
+ */
+FirstOrderPlant MakeLiftPlant(const PlantParameters& parameters);
+
+}  // namespace autosim
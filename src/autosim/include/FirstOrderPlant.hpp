@@ -0,0 +1,84 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <units/time.h>
+
+namespace autosim {
+
+/**
+ * A motor-driven mechanism whose speed approaches its motor output times its
+ * free speed with a first-order lag.
+ *
+ * Positions and speeds are in the mechanism's distance units, e.g., inches.
+ */
+class FirstOrderPlant {
+public:
+    /**
+     * Constructs a FirstOrderPlant at rest at position zero.
+     *
+     * @param freeSpeed    Speed at full output in distance units per second.
+     * @param timeConstant Time constant of the lag from output to speed.
+     * @param min          The lowest position, e.g., a hard stop.
+     * @param max          The highest position.
+     */
+    FirstOrderPlant(double freeSpeed, units::second_t timeConstant,
+                    double min = -std::numeric_limits<double>::infinity(),
+                    double max = std::numeric_limits<double>::infinity())
+        : m_freeSpeed{freeSpeed},
+          m_timeConstant{timeConstant.to<double>()},
+          m_min{min},
+          m_max{max} {}
+
+    /**
+     * Puts the mechanism at rest at a position.
+     */
+    void Reset(double position) {
+        m_position = std::clamp(position, m_min, m_max);
+        m_speed = 0.0;
+    }
+
+    /**
+     * Advances the mechanism by dt with a motor output held constant.
+     *
+     * @param output Motor output between -1 and 1. It's clamped to that range.
+     * @param dt     How long to advance by.
+     */
+    void Update(double output, units::second_t dt) {
+        double targetSpeed = std::clamp(output, -1.0, 1.0) * m_freeSpeed;
+
+        // Exact solution of the first-order lag over dt, so the model is
+        // stable for any tick length
+        double decay = std::exp(-dt.to<double>() / m_timeConstant);
+        double error = m_speed - targetSpeed;
+        m_position += targetSpeed * dt.to<double>() +
+                      error * m_timeConstant * (1.0 - decay);
+        m_speed = targetSpeed + error * decay;
+
+        if (m_position <= m_min || m_position >= m_max) {
+            m_position = std::clamp(m_position, m_min, m_max);
+            m_speed = 0.0;
+        }
+    }
+
+    // Returns the position in distance units
+    double GetPosition() const { return m_position; }
+
+    // Returns the speed in distance units per second
+    double GetSpeed() const { return m_speed; }
+
+private:
+    double m_freeSpeed;
+    double m_timeConstant;
+    double m_min;
+    double m_max;
+
+    double m_position = 0.0;
+    double m_speed = 0.0;
+};
+
+}  // namespace autosim
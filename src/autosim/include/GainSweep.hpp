@@ -0,0 +1,85 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <units/acceleration.h>
+#include <units/length.h>
+#include <units/time.h>
+#include <units/velocity.h>
+
+namespace autosim {
+
+/**
+ * A subsystem whose ProfiledPIDController can be tuned.
+ */
+enum class TunedSubsystem {
+    // Drivetrain's left and right controllers. Their gains are per foot.
+    kDrivetrain,
+
+    // Elevator's lift controller. Its gains are per inch.
+    kElevator
+};
+
+/**
+ * A ProfiledPIDController's gains and motion profile constraints.
+ */
+struct Gains {
+    double kp = 0.0;
+    double ki = 0.0;
+    double kd = 0.0;
+    units::feet_per_second_t maxV = 0_fps;
+    units::feet_per_second_squared_t maxA = 0_fps_sq;
+};
+
+/**
+ * How a set of gains performed across a subsystem's simulated moves.
+ */
+struct GainScore {
+    Gains gains;
+
+    // Lower is better. See SweepGains().
+    double score = 0.0;
+
+    // True if every move ended within tolerance of its goal
+    bool settled = false;
+
+    // The longest time a move took to stay within tolerance of its goal
+    units::second_t settlingTime = 0_s;
+
+    // The furthest a move went past its goal
+    units::inch_t overshoot = 0_in;
+
+    // Mean absolute motor voltage across the moves
+    double meanVoltage = 0.0;
+
+    // A label for gains that are in the code, or empty
+    std::string label;
+};
+
+/**
+ * Simulates a subsystem's closed-loop moves with each combination of gains in
+ * a grid, and returns the results sorted by score.
+ *
+ * Each combination is run against the nominal plant and randomized ones from
+ * RandomizePlant(), so gains that only work for one plant score poorly. The
+ * score is the longest settling time in seconds, plus 0.1 per inch of the
+ * largest overshoot, plus 0.05 per volt of mean voltage. Combinations that
+ * don't settle get another 10. The gains currently in the code are included
+ * and labeled, so the results can be compared with them.
+ *
+ * The simulations are split between a pool of threads. They don't touch the
+ * HAL simulation, so they run concurrently within one process.
+ *
+ * @param subsystem The subsystem to tune.
+ * @param threads   Number of threads to simulate on.
+ * @param seed      Seed for the randomized plants.
+ */
+std::vector<GainScore> SweepGains(TunedSubsystem subsystem,
+                                  unsigned int threads, uint32_t seed);
+
+}  // namespace autosim
@@ -0,0 +1,102 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "AutoSim.hpp"
+
+namespace autosim {
+
+/**
+ * Summary statistics of a set of samples.
+ */
+struct Distribution {
+    double mean = 0.0;
+    double stddev = 0.0;
+    double p5 = 0.0;
+    double median = 0.0;
+    double p95 = 0.0;
+
+    /**
+     * Returns the distribution of the samples, or all zeroes if there are
+     * none.
+     */
+    static Distribution Of(std::vector<double> samples);
+};
+
+/**
+ * The results of many simulated runs of one autonomous mode.
+ */
+struct ModeSummary {
+    std::string mode;
+    size_t trials = 0;
+
+    // How many trials the mode returned before autonomous ended in
+    size_t finished = 0;
+
+    // Only covers the trials which finished
+    Distribution finishTime;
+
+    // In inches
+    Distribution leftDistance;
+    Distribution rightDistance;
+    Distribution elevatorHeight;
+};
+
+/**
+ * Returns plant parameters for a Monte Carlo trial, randomized around the
+ * defaults.
+ *
+ * The drivetrain's free speed varies by 8% between trials to model the battery
+ * and carpet, and each side varies by another 3% to model friction in its
+ * gearbox. The elevator's free speed varies by 8% and the time constant is
+ * between 70 and 130 ms. Encoder readings have 0.05 inches of noise.
+ *
+ * The parameters only depend on the seed and trial, so any worker can run any
+ * trial.
+ *
+ * @param seed  Seed of the whole Monte Carlo run.
+ * @param trial Index of the trial.
+ */
+PlantParameters RandomizePlant(uint32_t seed, size_t trial);
+
+/**
+ * Runs an autonomous mode many times with randomized plant parameters.
+ *
+ * The HAL simulation is global to a process, so each worker is a separate
+ * process running RunWorker() with its own Robot and simulated devices. The
+ * trials are split evenly between the workers, which all run at once.
+ *
+ * @param executable Path of this program, which the workers are started as.
+ * @param mode       Name of the autonomous mode.
+ * @param trials     Number of trials.
+ * @param seed       Seed the trials' plant parameters are derived from.
+ * @param workers    Number of worker processes.
+ * @throws std::invalid_argument if the mode's name has characters other than
+ *         letters, digits, '_', and '-'.
+ * @throws std::runtime_error if a worker fails.
+ */
+ModeSummary RunMonteCarlo(const std::string& executable,
+                          const std::string& mode, size_t trials,
+                          uint32_t seed, unsigned int workers);
+
+/**
+ * Runs a worker's share of the trials for RunMonteCarlo().
+ *
+ * Each result is printed to stdout on a line starting with "result", so other
+ * output from the robot code is ignored.
+ *
+ * @param mode   Name of the autonomous mode.
+ * @param first  Index of the first trial.
+ * @param count  Number of trials.
+ * @param seed   Seed the trials' plant parameters are derived from.
+ */
+void RunWorker(const std::string& mode, size_t first, size_t count,
+               uint32_t seed);
+
+}  // namespace autosim
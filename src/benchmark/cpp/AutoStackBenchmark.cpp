@@ -0,0 +1,281 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include <units/time.h>
+
+#include "Benchmark.hpp"
+#include "InlineFunction.hpp"
+#include "StateMachine.hpp"
+#include "TypedStateMachine.hpp"
+
+namespace {
+
+enum AutoStackState {
+    S_IDLE,
+    S_WAIT_INITIAL_HEIGHT,
+    S_SEEK_DROP_TOTES,
+    S_RELEASE,
+    S_SEEK_GROUND,
+    S_GRAB,
+    S_SEEK_HALF_TOTE,
+    S_INTAKE_IN
+};
+
+/**
+ * Stands in for Elevator so its AUTO_STACK machine can be benchmarked without
+ * hardware. AtGoal() and the grab timer report true every few calls, so the
+ * machine cycles through every state like a real auto-stack does.
+ */
+class FakeElevator {
+public:
+    bool startAutoStacking = true;
+
+    bool AtGoal() { return ++m_goalPolls % 5 == 0; }
+    bool HasPeriodPassed() { return ++m_timerPolls % 10 == 0; }
+    void SetGoal(double goal) { m_goal = goal; }
+    double GetGoal() const { return m_goal; }
+    void ElevatorGrab(bool grab) { m_elevatorGrabbed = grab; }
+    void IntakeGrab(bool grab) { m_intakeGrabbed = grab; }
+
+private:
+    int m_goalPolls = 0;
+    int m_timerPolls = 0;
+    double m_goal = 0.0;
+    bool m_elevatorGrabbed = false;
+    bool m_intakeGrabbed = false;
+};
+
+// Builds AUTO_STACK with the std::function-based string API
+void AddStates(StateMachine& sm, FakeElevator& elevator) {
+    FakeElevator* e = &elevator;
+
+    State state{"IDLE"};
+    state.entry = [e] { e->startAutoStacking = false; };
+    state.transition = [e] {
+        return e->startAutoStacking ? "WAIT_INITIAL_HEIGHT" : "";
+    };
+    sm.AddState(std::move(state));
+    sm.SetState("IDLE");
+
+    state = State{"WAIT_INITIAL_HEIGHT"};
+    state.entry = [e] { e->SetGoal(16.0); };
+    state.transition = [e] { return e->AtGoal() ? "SEEK_DROP_TOTES" : ""; };
+    sm.AddState(std::move(state));
+
+    state = State{"SEEK_DROP_TOTES"};
+    state.entry = [e] { e->SetGoal(e->GetGoal() - 5.0); };
+    state.transition = [e] { return e->AtGoal() ? "RELEASE" : ""; };
+    sm.AddState(std::move(state));
+
+    state = State{"RELEASE"};
+    state.entry = [e] { e->ElevatorGrab(false); };
+    state.transition = [e] {
+        return e->HasPeriodPassed() ? "SEEK_GROUND" : "";
+    };
+    sm.AddState(std::move(state));
+
+    state = State{"SEEK_GROUND"};
+    state.entry = [e] { e->SetGoal(0.0); };
+    state.transition = [e] { return e->AtGoal() ? "GRAB" : ""; };
+    sm.AddState(std::move(state));
+
+    state = State{"GRAB"};
+    state.entry = [e] { e->ElevatorGrab(true); };
+    state.transition = [e] {
+        return e->HasPeriodPassed() ? "SEEK_HALF_TOTE" : "";
+    };
+    sm.AddState(std::move(state));
+
+    state = State{"SEEK_HALF_TOTE"};
+    state.entry = [e] { e->SetGoal(28.76); };
+    state.transition = [e] { return e->AtGoal() ? "INTAKE_IN" : ""; };
+    sm.AddState(std::move(state));
+
+    state = State{"INTAKE_IN"};
+    state.entry = [e] { e->IntakeGrab(true); };
+    state.transition = [e] { return e->HasPeriodPassed() ? "IDLE" : ""; };
+    sm.AddState(std::move(state));
+}
+
+/* Builds AUTO_STACK with TypedState, with the same states and transitions as
+ * the string version so the two only differ in how they store callables.
+ *
+ * If useTimeouts is true, the grab delays use state timeouts serviced by the
+ * timer wheel instead, like Elevator does. They're close to the string
+ * version's timer polling at a 20 ms period.
+ */
+void AddStates(TypedStateMachine<AutoStackState>& sm, FakeElevator& elevator,
+               bool useTimeouts = false) {
+    using Transition = TypedState<AutoStackState>::Transition;
+    FakeElevator* e = &elevator;
+
+    // Makes a state wait for the grab timer, then go to next
+    auto setDelay = [&](TypedState<AutoStackState>& state, AutoStackState next,
+                        units::second_t timeout) {
+        if (useTimeouts) {
+            state.events = 0;
+            state.timeout = timeout;
+            state.timeoutState = next;
+        } else {
+            state.transition = [e, next]() -> Transition {
+                if (e->HasPeriodPassed()) {
+                    return next;
+                }
+                return std::nullopt;
+            };
+        }
+    };
+
+    TypedState<AutoStackState> state;
+    state.entry = [e] { e->startAutoStacking = false; };
+    state.transition = [e]() -> Transition {
+        if (e->startAutoStacking) {
+            return S_WAIT_INITIAL_HEIGHT;
+        }
+        return std::nullopt;
+    };
+    sm.AddState(S_IDLE, std::move(state));
+    sm.SetState(S_IDLE);
+
+    state = TypedState<AutoStackState>{};
+    state.entry = [e] { e->SetGoal(16.0); };
+    state.transition = [e]() -> Transition {
+        if (e->AtGoal()) {
+            return S_SEEK_DROP_TOTES;
+        }
+        return std::nullopt;
+    };
+    sm.AddState(S_WAIT_INITIAL_HEIGHT, std::move(state));
+
+    state = TypedState<AutoStackState>{};
+    state.entry = [e] { e->SetGoal(e->GetGoal() - 5.0); };
+    state.transition = [e]() -> Transition {
+        if (e->AtGoal()) {
+            return S_RELEASE;
+        }
+        return std::nullopt;
+    };
+    sm.AddState(S_SEEK_DROP_TOTES, std::move(state));
+
+    state = TypedState<AutoStackState>{};
+    state.entry = [e] { e->ElevatorGrab(false); };
+    setDelay(state, S_SEEK_GROUND, 0.2_s);
+    sm.AddState(S_RELEASE, std::move(state));
+
+    state = TypedState<AutoStackState>{};
+    state.entry = [e] { e->SetGoal(0.0); };
+    state.transition = [e]() -> Transition {
+        if (e->AtGoal()) {
+            return S_GRAB;
+        }
+        return std::nullopt;
+    };
+    sm.AddState(S_SEEK_GROUND, std::move(state));
+
+    state = TypedState<AutoStackState>{};
+    state.entry = [e] { e->ElevatorGrab(true); };
+    setDelay(state, S_SEEK_HALF_TOTE, 0.4_s);
+    sm.AddState(S_GRAB, std::move(state));
+
+    state = TypedState<AutoStackState>{};
+    state.entry = [e] { e->SetGoal(28.76); };
+    state.transition = [e]() -> Transition {
+        if (e->AtGoal()) {
+            return S_INTAKE_IN;
+        }
+        return std::nullopt;
+    };
+    sm.AddState(S_SEEK_HALF_TOTE, std::move(state));
+
+    state = TypedState<AutoStackState>{};
+    state.entry = [e] { e->IntakeGrab(true); };
+    setDelay(state, S_IDLE, 0.2_s);
+    sm.AddState(S_INTAKE_IN, std::move(state));
+}
+
+void BM_AutoStackBuildStdFunction(bench::State& state) {
+    FakeElevator elevator;
+    for (auto _ : state) {
+        StateMachine sm{"AUTO_STACK"};
+        AddStates(sm, elevator);
+        bench::DoNotOptimize(sm);
+    }
+}
+BENCHMARK(BM_AutoStackBuildStdFunction);
+
+void BM_AutoStackBuildInline(bench::State& state) {
+    FakeElevator elevator;
+    for (auto _ : state) {
+        TypedStateMachine<AutoStackState> sm;
+        AddStates(sm, elevator);
+        bench::DoNotOptimize(sm);
+    }
+}
+BENCHMARK(BM_AutoStackBuildInline);
+
+void BM_AutoStackRunStdFunction(bench::State& state) {
+    FakeElevator elevator;
+    StateMachine sm{"AUTO_STACK"};
+    AddStates(sm, elevator);
+
+    for (auto _ : state) {
+        // Keep restarting the stack so every state is visited
+        elevator.startAutoStacking = true;
+        sm.run();
+    }
+}
+BENCHMARK(BM_AutoStackRunStdFunction);
+
+void BM_AutoStackRunInline(bench::State& state) {
+    FakeElevator elevator;
+    TypedStateMachine<AutoStackState> sm;
+    AddStates(sm, elevator);
+
+    for (auto _ : state) {
+        // Keep restarting the stack so every state is visited
+        elevator.startAutoStacking = true;
+        sm.Run();
+    }
+}
+BENCHMARK(BM_AutoStackRunInline);
+
+// Like BM_AutoStackRunInline, but the grab delays are state timeouts
+void BM_AutoStackRunTimeouts(bench::State& state) {
+    FakeElevator elevator;
+    TypedStateMachine<AutoStackState> sm;
+    AddStates(sm, elevator, true);
+
+    for (auto _ : state) {
+        // Keep restarting the stack so every state is visited
+        elevator.startAutoStacking = true;
+        sm.Run();
+    }
+}
+BENCHMARK(BM_AutoStackRunTimeouts);
+
+void BM_CallStdFunction(bench::State& state) {
+    FakeElevator elevator;
+    FakeElevator* e = &elevator;
+    std::function<bool()> func = [e] { return e->AtGoal(); };
+
+    for (auto _ : state) {
+        bench::DoNotOptimize(func());
+    }
+}
+BENCHMARK(BM_CallStdFunction);
+
+void BM_CallInlineFunction(bench::State& state) {
+    FakeElevator elevator;
+    FakeElevator* e = &elevator;
+    InlineFunction<bool()> func = [e] { return e->AtGoal(); };
+
+    for (auto _ : state) {
+        bench::DoNotOptimize(func());
+    }
+}
+BENCHMARK(BM_CallInlineFunction);
+
+}  // namespace
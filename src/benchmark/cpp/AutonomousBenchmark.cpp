@@ -0,0 +1,329 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <wpi/condition_variable.h>
+#include <wpi/mutex.h>
+
+#include "AutonomousChooser.hpp"
+#include "Benchmark.hpp"
+#include "Fiber.hpp"
+
+namespace {
+
+/**
+ * The thread and condition variable handoff AutonomousChooser used before it
+ * ran autonomous modes in a Fiber, kept to compare against.
+ */
+class ThreadHandoff {
+public:
+    explicit ThreadHandoff(std::function<void(ThreadHandoff&)> func) {
+        m_awaitingAuton = true;
+        m_autonThread = std::thread{[=] {
+            m_autonLock.lock();
+            m_autonRunning = true;
+            func(*this);
+            m_autonRunning = false;
+            Return();
+            m_autonLock.unlock();
+        }};
+        m_cond.wait(m_mainLock, [&] { return !m_awaitingAuton; });
+    }
+
+    ~ThreadHandoff() {
+        AwaitRunAutonomous();
+        m_autonThread.join();
+    }
+
+    void YieldToMain() {
+        m_awaitingAuton = false;
+        m_cond.notify_one();
+        m_cond.wait(m_autonLock, [&] { return m_awaitingAuton; });
+    }
+
+    void Return() {
+        m_awaitingAuton = false;
+        m_cond.notify_one();
+    }
+
+    void AwaitRunAutonomous() {
+        if (m_autonRunning) {
+            m_awaitingAuton = true;
+            m_cond.notify_one();
+            m_cond.wait(m_mainLock, [&] { return !m_awaitingAuton; });
+        }
+    }
+
+private:
+    std::thread m_autonThread;
+    wpi::mutex m_autonMutex;
+    std::unique_lock<wpi::mutex> m_mainLock{m_autonMutex};
+    std::unique_lock<wpi::mutex> m_autonLock{m_autonMutex, std::defer_lock};
+    wpi::condition_variable m_cond;
+    bool m_awaitingAuton = false;
+    bool m_autonRunning = false;
+};
+
+/* Each iteration is one autonomous tick: the main thread hands control to the
+ * autonomous mode, which immediately yields back. The time is the handoff
+ * latency the main robot thread sees.
+ */
+
+void BM_AutonHandoffThread(bench::State& state) {
+    bool stop = false;
+    ThreadHandoff handoff{[&](ThreadHandoff& self) {
+        while (!stop) {
+            self.YieldToMain();
+        }
+    }};
+
+    for (auto _ : state) {
+        handoff.AwaitRunAutonomous();
+    }
+    stop = true;
+}
+BENCHMARK(BM_AutonHandoffThread);
+
+void BM_AutonHandoffFiber(bench::State& state) {
+    bool stop = false;
+    frc3512::Fiber* self = nullptr;
+    frc3512::Fiber fiber{[&] {
+        while (!stop) {
+            self->Suspend();
+        }
+    }};
+    self = &fiber;
+    fiber.Resume();
+
+    for (auto _ : state) {
+        fiber.Resume();
+    }
+    stop = true;
+    fiber.Resume();
+}
+BENCHMARK(BM_AutonHandoffFiber);
+
+void BM_AutonHandoffChooser(bench::State& state) {
+    bool stop = false;
+    frc3512::AutonomousChooser* chooser = nullptr;
+    auto yieldUntilStopped = [&] {
+        while (!stop) {
+            chooser->YieldToMain();
+        }
+    };
+
+    frc3512::AutonomousChooser autonChooser{"Yield", yieldUntilStopped};
+    chooser = &autonChooser;
+    autonChooser.AwaitStartAutonomous();
+
+    for (auto _ : state) {
+        autonChooser.AwaitRunAutonomous();
+    }
+    stop = true;
+    autonChooser.EndAutonomous();
+}
+BENCHMARK(BM_AutonHandoffChooser);
+
+// The mode waits with WaitUntil(), so each tick only checks the condition
+void BM_AutonWaitChooser(bench::State& state) {
+    bool stop = false;
+    frc3512::AutonomousChooser* chooser = nullptr;
+    auto waitUntilStopped = [&] {
+        chooser->WaitUntil([&] { return stop; });
+    };
+
+    frc3512::AutonomousChooser autonChooser{"Wait", waitUntilStopped};
+    chooser = &autonChooser;
+    autonChooser.AwaitStartAutonomous();
+
+    for (auto _ : state) {
+        autonChooser.AwaitRunAutonomous();
+    }
+    stop = true;
+    autonChooser.EndAutonomous();
+}
+BENCHMARK(BM_AutonWaitChooser);
+
+// The mode runs two tasks with Parallel() which each yield every tick
+void BM_AutonParallelChooser(bench::State& state) {
+    bool stop = false;
+    frc3512::AutonomousChooser* chooser = nullptr;
+    auto yieldUntilStopped = [&] {
+        while (!stop) {
+            chooser->YieldToMain();
+        }
+    };
+    auto parallel = [&] {
+        chooser->Parallel({yieldUntilStopped, yieldUntilStopped});
+    };
+
+    frc3512::AutonomousChooser autonChooser{"Parallel", parallel};
+    chooser = &autonChooser;
+    autonChooser.AwaitStartAutonomous();
+
+    for (auto _ : state) {
+        autonChooser.AwaitRunAutonomous();
+    }
+    stop = true;
+    autonChooser.EndAutonomous();
+}
+BENCHMARK(BM_AutonParallelChooser);
+
+/* Each iteration starts an autonomous mode whose first statement is an
+ * actuation, then yields. The time is from starting autonomous until the main
+ * robot thread gets control back after that first tick. Tearing the mode down
+ * isn't timed.
+ *
+ * AutonomousChooser itself isn't benchmarked here since it logs each start to
+ * the console; BM_AutonStartWorker mirrors its persistent worker instead.
+ */
+
+// Stands in for setting a motor output
+volatile double g_output = 0.0;
+
+// A new thread per start, as AutonomousChooser did with threads
+void BM_AutonStartThread(bench::State& state) {
+    for (auto _ : state) {
+        bool stop = false;
+        auto handoff =
+            std::make_unique<ThreadHandoff>([&](ThreadHandoff& self) {
+                g_output = 1.0;
+                while (!stop) {
+                    self.YieldToMain();
+                }
+            });
+
+        state.PauseTiming();
+        stop = true;
+        handoff.reset();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_AutonStartThread);
+
+// A new fiber per start, as AutonomousChooser did before it had a worker
+void BM_AutonStartFiber(bench::State& state) {
+    for (auto _ : state) {
+        bool stop = false;
+        frc3512::Fiber* self = nullptr;
+        auto fiber = std::make_unique<frc3512::Fiber>([&] {
+            g_output = 1.0;
+            while (!stop) {
+                self->Suspend();
+            }
+        });
+        self = fiber.get();
+        fiber->Resume();
+
+        state.PauseTiming();
+        stop = true;
+        fiber->Resume();
+        fiber.reset();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_AutonStartFiber);
+
+// A persistent, already started fiber which is handed each mode to run
+void BM_AutonStartWorker(bench::State& state) {
+    bool stop = false;
+    std::function<void()>* dispatched = nullptr;
+    frc3512::Fiber* self = nullptr;
+    frc3512::Fiber worker{[&] {
+        while (true) {
+            if (auto auton = std::exchange(dispatched, nullptr)) {
+                (*auton)();
+            }
+            self->Suspend();
+        }
+    }};
+    self = &worker;
+    worker.Resume();
+
+    std::function<void()> auton = [&] {
+        g_output = 1.0;
+        while (!stop) {
+            self->Suspend();
+        }
+    };
+
+    for (auto _ : state) {
+        dispatched = &auton;
+        worker.Resume();
+
+        state.PauseTiming();
+        stop = true;
+        worker.Resume();
+        stop = false;
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_AutonStartWorker);
+
+/* Each iteration ends an autonomous mode that's waiting for its next tick. The
+ * time is from the main robot thread asking it to stop until the mode has
+ * exited and the main robot thread can continue. Starting the mode isn't
+ * timed.
+ */
+
+// The mode polls a flag after each tick and the thread is joined, as
+// autonomous modes did with IsAutonomousEnabled()
+void BM_AutonEndThread(bench::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        bool enabled = true;
+        auto handoff =
+            std::make_unique<ThreadHandoff>([&](ThreadHandoff& self) {
+                while (true) {
+                    self.YieldToMain();
+                    if (!enabled) {
+                        return;
+                    }
+                }
+            });
+        state.ResumeTiming();
+
+        enabled = false;
+        handoff.reset();
+    }
+}
+BENCHMARK(BM_AutonEndThread);
+
+// The mode's pending yield throws, as with AutonomousCancelled
+void BM_AutonEndFiber(bench::State& state) {
+    struct Cancelled {};
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        bool cancelled = false;
+        frc3512::Fiber* self = nullptr;
+        auto fiber = std::make_unique<frc3512::Fiber>([&] {
+            try {
+                while (true) {
+                    self->Suspend();
+                    if (cancelled) {
+                        throw Cancelled{};
+                    }
+                }
+            } catch (const Cancelled&) {
+            }
+        });
+        self = fiber.get();
+        fiber->Resume();
+        state.ResumeTiming();
+
+        cancelled = true;
+        fiber->Resume();
+
+        state.PauseTiming();
+        fiber.reset();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_AutonEndFiber);
+
+}  // namespace
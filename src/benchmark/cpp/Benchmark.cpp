@@ -0,0 +1,107 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Benchmark.hpp"
+
+#include <chrono>
+#include <memory>
+
+#include <fmt/core.h>
+
+namespace bench {
+
+namespace {
+
+// Runs are repeated with more iterations until they take at least this long
+constexpr int64_t kMinRunTimeNs = 200'000'000;
+
+constexpr uint64_t kMaxIterations = 1'000'000'000;
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::vector<std::unique_ptr<Benchmark>>& Registry() {
+    static std::vector<std::unique_ptr<Benchmark>> registry;
+    return registry;
+}
+
+void Run(const std::string& name, Function func, int64_t arg) {
+    uint64_t iterations = 1;
+    while (true) {
+        State state{iterations, arg};
+        func(state);
+        state.PauseTiming();
+
+        int64_t elapsed = state.ElapsedNs();
+        if (elapsed >= kMinRunTimeNs || iterations >= kMaxIterations) {
+            fmt::print("{:<48} {:>14.1f} ns {:>12}\n", name,
+                       static_cast<double>(elapsed) / iterations, iterations);
+            return;
+        }
+
+        // Aim for 1.4x the minimum run time, growing by at most 10x per run
+        double scale = elapsed > 0 ? 1.4 * kMinRunTimeNs / elapsed : 10.0;
+        if (scale > 10.0) {
+            scale = 10.0;
+        }
+        uint64_t next = static_cast<uint64_t>(iterations * scale);
+        iterations = next > iterations ? next : iterations + 1;
+    }
+}
+
+}  // namespace
+
+State::Iterator State::begin() {
+    ResumeTiming();
+    return Iterator{m_iterations};
+}
+
+void State::PauseTiming() {
+    if (m_startNs != 0) {
+        m_elapsedNs += NowNs() - m_startNs;
+        m_startNs = 0;
+    }
+}
+
+void State::ResumeTiming() {
+    if (m_startNs == 0) {
+        m_startNs = NowNs();
+    }
+}
+
+Benchmark::Benchmark(std::string_view name, Function func)
+    : m_name{name}, m_func{func} {}
+
+Benchmark* Benchmark::Arg(int64_t arg) {
+    m_args.emplace_back(arg);
+    return this;
+}
+
+Benchmark* RegisterBenchmark(std::string_view name, Function func) {
+    Registry().emplace_back(std::make_unique<Benchmark>(name, func));
+    return Registry().back().get();
+}
+
+void RunAll(std::string_view filter) {
+    fmt::print("{:<48} {:>17} {:>12}\n", "Benchmark", "Time", "Iterations");
+    fmt::print("{:-<79}\n", "");
+
+    for (const auto& benchmark : Registry()) {
+        if (benchmark->m_name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        if (benchmark->m_args.empty()) {
+            Run(benchmark->m_name, benchmark->m_func, 0);
+        } else {
+            for (auto arg : benchmark->m_args) {
+                Run(fmt::format("{}/{}", benchmark->m_name, arg),
+                    benchmark->m_func, arg);
+            }
+        }
+    }
+}
+
+}  // namespace bench
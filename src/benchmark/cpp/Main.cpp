@@ -0,0 +1,13 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <hal/HAL.h>
+
+#include "Benchmark.hpp"
+
+int main(int argc, char** argv) {
+    HAL_Initialize(500, 0);
+
+    // An optional argument only runs benchmarks whose names contain it
+    bench::RunAll(argc > 1 ? argv[1] : "");
+    return 0;
+}
@@ -0,0 +1,178 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <stddef.h>
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "Benchmark.hpp"
+#include "StateMachine.hpp"
+#include "TypedStateMachine.hpp"
+#include "subsystems/Elevator.hpp"
+
+namespace {
+
+// Each synthetic state moves to the next one after this many calls to run()
+constexpr int kTicksPerState = 4;
+
+/* Names are longer than libstdc++'s small string buffer (15 characters), like
+ * the real state names (e.g., "WAIT_INITIAL_HEIGHT"), so copying one
+ * allocates.
+ */
+std::string SyntheticName(size_t index) {
+    return fmt::format("SYNTHETIC_STATE_{:04}", index);
+}
+
+/**
+ * A chain of states which cycles from the first state to the last, spending
+ * kTicksPerState calls to run() in each.
+ */
+struct SyntheticStringMachine {
+    StateMachine sm{"SYNTHETIC"};
+    std::vector<std::string> names;
+    int ticks = 0;
+
+    explicit SyntheticStringMachine(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            names.emplace_back(SyntheticName(i));
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const std::string& next = names[(i + 1) % count];
+
+            State state{names[i]};
+            state.entry = [this] { ticks = 0; };
+            state.run = [this] { ++ticks; };
+            state.transition = [this, &next] {
+                return ticks >= kTicksPerState ? next : "";
+            };
+            sm.AddState(std::move(state));
+        }
+        sm.SetState(names[0]);
+    }
+};
+
+// The same machine built with TypedStateMachine
+struct SyntheticTypedMachine {
+    TypedStateMachine<size_t> sm;
+    int ticks = 0;
+
+    explicit SyntheticTypedMachine(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t next = (i + 1) % count;
+
+            TypedState<size_t> state;
+            state.entry = [this] { ticks = 0; };
+            state.run = [this] { ++ticks; };
+            state.transition = [this, next]() -> std::optional<size_t> {
+                if (ticks >= kTicksPerState) {
+                    return next;
+                }
+                return std::nullopt;
+            };
+            sm.AddState(i, std::move(state));
+        }
+        sm.SetState(0);
+    }
+};
+
+void BM_StateMachineRun(bench::State& state) {
+    SyntheticStringMachine machine{static_cast<size_t>(state.range(0))};
+    for (auto _ : state) {
+        machine.sm.run();
+    }
+}
+BENCHMARK(BM_StateMachineRun)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_TypedStateMachineRun(bench::State& state) {
+    SyntheticTypedMachine machine{static_cast<size_t>(state.range(0))};
+    for (auto _ : state) {
+        machine.sm.Run();
+    }
+}
+BENCHMARK(BM_TypedStateMachineRun)->Arg(10)->Arg(100)->Arg(1000);
+
+// Visits states in an order which defeats the branch predictor and caches
+std::vector<size_t> ScatteredOrder(size_t count) {
+    std::vector<size_t> order;
+    for (size_t i = 0; i < count; ++i) {
+        order.emplace_back((i * 7919) % count);
+    }
+    return order;
+}
+
+void BM_StateMachineSetState(bench::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    SyntheticStringMachine machine{count};
+    auto order = ScatteredOrder(count);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        bench::DoNotOptimize(machine.sm.SetState(machine.names[order[i]]));
+        i = i + 1 < count ? i + 1 : 0;
+    }
+}
+BENCHMARK(BM_StateMachineSetState)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_TypedStateMachineSetState(bench::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    SyntheticTypedMachine machine{count};
+    auto order = ScatteredOrder(count);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        bench::DoNotOptimize(machine.sm.SetState(order[i]));
+        i = i + 1 < count ? i + 1 : 0;
+    }
+}
+BENCHMARK(BM_TypedStateMachineSetState)->Arg(10)->Arg(100)->Arg(1000);
+
+// GetState() returns a copy of the current state's name
+void BM_StateMachineGetState(bench::State& state) {
+    SyntheticStringMachine machine{static_cast<size_t>(state.range(0))};
+    for (auto _ : state) {
+        bench::DoNotOptimize(machine.sm.GetState());
+    }
+}
+BENCHMARK(BM_StateMachineGetState)->Arg(10)->Arg(1000);
+
+void BM_TypedStateMachineGetState(bench::State& state) {
+    SyntheticTypedMachine machine{static_cast<size_t>(state.range(0))};
+    for (auto _ : state) {
+        bench::DoNotOptimize(machine.sm.GetState());
+    }
+}
+BENCHMARK(BM_TypedStateMachineGetState)->Arg(10)->Arg(1000);
+
+/* The real AUTO_STACK machine. There's no elevator physics in simulation, so
+ * the elevator never reaches its goal and the machine waits in
+ * S_WAIT_INITIAL_HEIGHT. This measures a typical tick of the elevator: sampling
+ * its sensors, UpdateState() with the controller, and sending motor output.
+ */
+void BM_ElevatorUpdateState(bench::State& state) {
+    Elevator elevator;
+    elevator.StackTotes();
+    for (auto _ : state) {
+        elevator.SampleSensors();
+        elevator.UpdateState();
+        elevator.FlushOutputs();
+    }
+}
+BENCHMARK(BM_ElevatorUpdateState);
+
+// Enters and leaves the real AUTO_STACK machine's S_STACKING state
+void BM_ElevatorStackCancel(bench::State& state) {
+    Elevator elevator;
+    for (auto _ : state) {
+        elevator.StackTotes();
+        elevator.UpdateState();
+        elevator.CancelStack();
+    }
+}
+BENCHMARK(BM_ElevatorStackCancel);
+
+}  // namespace
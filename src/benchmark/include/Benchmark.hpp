@@ -0,0 +1,156 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A minimal microbenchmark harness with a Google Benchmark-style interface.
+ *
+ * Benchmarks are plain functions registered with BENCHMARK(). Each one loops
+ * over a bench::State, and the harness grows the iteration count until a run
+ * takes long enough to time reliably:
+ *
+ * @code
+ * static void BM_Foo(bench::State& state) {
+ *     for (auto _ : state) {
+ *         bench::DoNotOptimize(Foo(state.range(0)));
+ *     }
+ * }
+ * BENCHMARK(BM_Foo)->Arg(10)->Arg(100);
+ * @endcode
+ */
+namespace bench {
+
+/**
+ * Per-run state passed to a benchmark function.
+ */
+class State {
+public:
+    // Marked unused so "for (auto _ : state)" doesn't warn
+    struct [[maybe_unused]] Value {};
+
+    class Iterator {
+    public:
+        explicit Iterator(uint64_t remaining) : m_remaining{remaining} {}
+
+        Value operator*() const { return {}; }
+
+        Iterator& operator++() {
+            --m_remaining;
+            return *this;
+        }
+
+        bool operator!=(const Iterator& rhs) const {
+            return m_remaining != rhs.m_remaining;
+        }
+
+    private:
+        uint64_t m_remaining;
+    };
+
+    State(uint64_t iterations, int64_t arg)
+        : m_iterations{iterations}, m_arg{arg} {}
+
+    Iterator begin();
+    Iterator end() { return Iterator{0}; }
+
+    /**
+     * Returns the argument registered with Arg(), or 0 if there was none.
+     */
+    int64_t range(int) const { return m_arg; }
+
+    uint64_t iterations() const { return m_iterations; }
+
+    /**
+     * Excludes the time until ResumeTiming() from the measurement. Used to
+     * hide per-iteration setup.
+     */
+    void PauseTiming();
+
+    void ResumeTiming();
+
+    /**
+     * Returns the measured time in nanoseconds.
+     */
+    int64_t ElapsedNs() const { return m_elapsedNs; }
+
+private:
+    uint64_t m_iterations;
+    int64_t m_arg;
+    int64_t m_startNs = 0;
+    int64_t m_elapsedNs = 0;
+};
+
+using Function = void (*)(State&);
+
+/**
+ * A registered benchmark. Arg() may be chained to run it once per argument.
+ */
+class Benchmark {
+public:
+    Benchmark(std::string_view name, Function func);
+
+    Benchmark* Arg(int64_t arg);
+
+private:
+    std::string m_name;
+    Function m_func;
+    std::vector<int64_t> m_args;
+
+    friend void RunAll(std::string_view filter);
+};
+
+/**
+ * Registers a benchmark. Called by the BENCHMARK() macro.
+ */
+Benchmark* RegisterBenchmark(std::string_view name, Function func);
+
+/**
+ * Runs every registered benchmark whose name contains filter and prints a
+ * table of the time per iteration.
+ */
+void RunAll(std::string_view filter = "");
+
+/**
+ * Prevents the compiler from optimizing away the computation of value.
+ */
+template <typename T>
+inline void DoNotOptimize(T&& value) {
+#ifdef _MSC_VER
+    static_cast<void>(*static_cast<const volatile char*>(
+        static_cast<const volatile void*>(&value)));
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+/**
+ * Prevents the compiler from reordering or eliding memory writes across this
+ * call.
+ */
+inline void ClobberMemory() {
+#ifdef _MSC_VER
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+}  // namespace bench
+
+#define BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_IMPL(a, b)
+
+#define BENCHMARK(func)                                          \
+    static ::bench::Benchmark* BENCHMARK_CONCAT(bench_, __LINE__) \
+        [[maybe_unused]] = ::bench::RegisterBenchmark(#func, func)
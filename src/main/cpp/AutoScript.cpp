@@ -0,0 +1,212 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "AutoScript.hpp"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+#include <system_error>
+
+#include <fmt/core.h>
+#include <wpi/FileSystem.h>
+#include <wpi/Path.h>
+
+#include "subsystems/Elevator.hpp"
+
+static_assert(sizeof(AutoScript::Instruction) == 16,
+              "Instruction isn't compact");
+
+namespace {
+
+// Splits a line into whitespace-separated words, dropping any comment
+std::vector<std::string> Tokenize(wpi::StringRef line) {
+    std::vector<std::string> tokens;
+
+    std::string token;
+    for (char c : line) {
+        if (c == '#') {
+            break;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!token.empty()) {
+                tokens.emplace_back(std::move(token));
+                token.clear();
+            }
+        } else {
+            token += c;
+        }
+    }
+    if (!token.empty()) {
+        tokens.emplace_back(std::move(token));
+    }
+
+    return tokens;
+}
+
+float ParseNumber(const std::string& token, float min, float max) {
+    char* end = nullptr;
+    float value = strtof(token.c_str(), &end);
+    if (end == token.c_str() || *end != '\0' || !std::isfinite(value)) {
+        throw std::invalid_argument{fmt::format("'{}' isn't a number", token)};
+    }
+    if (value < min || value > max) {
+        throw std::invalid_argument{
+            fmt::format("{} isn't between {} and {}", token, min, max)};
+    }
+    return value;
+}
+
+void ExpectArgs(const std::vector<std::string>& tokens, size_t min,
+                size_t max) {
+    size_t count = tokens.size() - 1;
+    if (count < min || count > max) {
+        throw std::invalid_argument{
+            fmt::format("wrong number of arguments to '{}'", tokens[0])};
+    }
+}
+
+AutoScript::Instruction CompileLine(const std::vector<std::string>& tokens) {
+    using Opcode = AutoScript::Opcode;
+
+    AutoScript::Instruction instruction{};
+    const auto& command = tokens[0];
+
+    if (command == "drive") {
+        ExpectArgs(tokens, 3, 4);
+        instruction.opcode = Opcode::kDrive;
+        instruction.args = {ParseNumber(tokens[1], 0.f, 15.f),
+                            ParseNumber(tokens[2], -1.f, 1.f),
+                            ParseNumber(tokens[3], -1.f, 1.f)};
+        if (tokens.size() == 5) {
+            if (tokens[4] != "quickturn") {
+                throw std::invalid_argument{
+                    fmt::format("expected 'quickturn', got '{}'", tokens[4])};
+            }
+            instruction.operand = 1;
+        }
+    } else if (command == "height") {
+        ExpectArgs(tokens, 1, 1);
+        instruction.opcode = Opcode::kSetHeight;
+        auto height = Elevator::FindHeightPreset(tokens[1]);
+        if (!height) {
+            throw std::invalid_argument{
+                fmt::format("unknown height '{}'", tokens[1])};
+        }
+        instruction.args[0] = height->to<float>();
+    } else if (command == "grab" || command == "release") {
+        ExpectArgs(tokens, 1, 1);
+        if (tokens[1] == "elevator") {
+            instruction.opcode = Opcode::kElevatorGrab;
+        } else if (tokens[1] == "intake") {
+            instruction.opcode = Opcode::kIntakeGrab;
+        } else {
+            throw std::invalid_argument{fmt::format(
+                "expected 'elevator' or 'intake', got '{}'", tokens[1])};
+        }
+        instruction.operand = command == "grab";
+    } else if (command == "stow" || command == "unstow") {
+        ExpectArgs(tokens, 1, 1);
+        if (tokens[1] != "intake") {
+            throw std::invalid_argument{
+                fmt::format("expected 'intake', got '{}'", tokens[1])};
+        }
+        instruction.opcode = Opcode::kStowIntake;
+        instruction.operand = command == "stow";
+    } else if (command == "intake") {
+        ExpectArgs(tokens, 1, 1);
+        instruction.opcode = Opcode::kSetIntakeDirection;
+        auto direction = Elevator::FindIntakeDirection(tokens[1]);
+        if (!direction) {
+            throw std::invalid_argument{
+                fmt::format("unknown intake direction '{}'", tokens[1])};
+        }
+        instruction.operand = *direction;
+    } else if (command == "wait") {
+        ExpectArgs(tokens, 1, 1);
+        if (tokens[1] == "goal") {
+            instruction.opcode = Opcode::kWaitForGoal;
+        } else {
+            instruction.opcode = Opcode::kWait;
+            instruction.args[0] = ParseNumber(tokens[1], 0.f, 15.f);
+        }
+    } else {
+        throw std::invalid_argument{
+            fmt::format("unknown command '{}'", command)};
+    }
+
+    return instruction;
+}
+
+std::string ReadFile(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::system_error{errno, std::generic_category(),
+                                "Failed to open " + path};
+    }
+
+    std::string contents;
+    char buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, count);
+    }
+    fclose(file);
+
+    return contents;
+}
+
+}  // namespace
+
+AutoScript::AutoScript(wpi::StringRef name, wpi::StringRef source)
+    : m_name{name} {
+    size_t lineNumber = 0;
+    while (!source.empty()) {
+        ++lineNumber;
+
+        auto [line, rest] = source.split('\n');
+        source = rest;
+
+        auto tokens = Tokenize(line);
+        if (tokens.empty()) {
+            continue;
+        }
+
+        try {
+            m_instructions.emplace_back(CompileLine(tokens));
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument{
+                fmt::format("line {}: {}", lineNumber, e.what())};
+        }
+    }
+}
+
+std::vector<AutoScript> AutoScript::LoadDirectory(wpi::StringRef directory) {
+    namespace fs = wpi::sys::fs;
+
+    std::vector<AutoScript> scripts;
+
+    std::error_code ec;
+    for (fs::directory_iterator it{directory, ec}, end; !ec && it != end;
+         it.increment(ec)) {
+        const auto& path = it->path();
+        if (wpi::sys::path::extension(path) != ".auto") {
+            continue;
+        }
+
+        try {
+            scripts.emplace_back(wpi::sys::path::stem(path), ReadFile(path));
+        } catch (const std::exception& e) {
+            fmt::print("Skipped autonomous script {}: {}\n", path, e.what());
+        }
+    }
+    if (ec) {
+        fmt::print("Failed to read autonomous scripts from {}: {}\n",
+                   directory.str(), ec.message());
+    }
+
+    return scripts;
+}
@@ -2,21 +2,55 @@
 
 #include "AutonomousChooser.hpp"
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
 
 #include <fmt/core.h>
 #include <frc/smartdashboard/SmartDashboard.h>
+#include <frc2/Timer.h>
 
 namespace frc3512 {
 
+namespace {
+
+/**
+ * Touches the top of the calling fiber's stack so its pages are mapped before
+ * an autonomous mode needs them.
+ */
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void PrefaultStack() {
+    volatile char buffer[64 * 1024];
+    for (size_t i = 0; i < sizeof(buffer); i += 1024) {
+        buffer[i] = 0;
+    }
+}
+
+constexpr units::second_t kNever{std::numeric_limits<double>::infinity()};
+
+}  // namespace
+
 AutonomousChooser::AutonomousChooser(wpi::StringRef name,
-                                     std::function<void()> func) {
-    m_defaultChoice = name;
-    m_choices[name] = func;
-    m_names.emplace_back(name);
+                                     std::function<void()> func,
+                                     std::vector<AutonomousMode> modes)
+    : m_modes{std::move(modes)} {
+    m_modes.push_back({name.str(), std::move(func)});
+    std::stable_sort(m_modes.begin(), m_modes.end(),
+                     [](const auto& lhs, const auto& rhs) {
+                         return lhs.name < rhs.name;
+                     });
 
-    m_selectedChoice = name;
-    m_selectedAuton = &m_choices[name];
+    for (const auto& mode : m_modes) {
+        m_names.emplace_back(mode.name);
+    }
+    m_defaultIndex = FindAutonomous(name);
+    m_selectedIndex = m_defaultIndex;
 
     frc::SmartDashboard::PutData("Autonomous modes", this);
 
@@ -26,38 +60,42 @@ AutonomousChooser::AutonomousChooser(wpi::StringRef name,
                 return;
             }
 
-            {
-                std::scoped_lock lock{m_mutex};
-                m_selectedChoice = event.value->GetString();
+            size_t index = FindAutonomous(event.value->GetString());
+            if (index == m_modes.size()) {
+                return;
             }
 
-            m_activeEntry.SetString(m_selectedChoice);
+            m_selectedIndex.store(index, std::memory_order_relaxed);
+            m_activeEntry.SetString(m_modes[index].name);
         },
         NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW | NT_NOTIFY_UPDATE |
             NT_NOTIFY_LOCAL);
+
+    StartWorker();
 }
 
 AutonomousChooser::~AutonomousChooser() {
     EndAutonomous();
-    m_selectedEntry.RemoveListener(m_selectedListenerHandle);
-}
-
-void AutonomousChooser::AddAutonomous(wpi::StringRef name,
-                                      std::function<void()> func) {
-    m_choices[name] = func;
-    m_names.emplace_back(name);
 
-    // Unlike std::map, wpi::StringMap elements are not sorted
-    std::sort(m_names.begin(), m_names.end());
+    // Let the workers' loops return so their stacks unwind
+    m_exiting = true;
+    m_autonFiber->Resume();
+    for (auto& task : m_tasks) {
+        if (task->fiber != nullptr) {
+            task->fiber->Resume();
+        }
+    }
 
-    m_optionsEntry.SetStringArray(m_names);
+    m_selectedEntry.RemoveListener(m_selectedListenerHandle);
 }
 
 void AutonomousChooser::SelectAutonomous(wpi::StringRef name) {
-    {
-        std::scoped_lock lock{m_mutex};
-        m_selectedChoice = name;
+    size_t index = FindAutonomous(name);
+    if (index == m_modes.size()) {
+        return;
     }
+
+    m_selectedIndex.store(index, std::memory_order_relaxed);
     m_selectedEntry.SetString(name);
 }
 
@@ -65,68 +103,400 @@ const std::vector<std::string>& AutonomousChooser::GetAutonomousNames() const {
     return m_names;
 }
 
+bool AutonomousChooser::IsAutonomousRunning() const { return m_autonRunning; }
+
 void AutonomousChooser::YieldToMain() {
-    m_awaitingAuton = false;
-    m_cond.notify_one();
-    m_cond.wait(m_autonLock, [&] { return m_awaitingAuton; });
+    auto fiber = m_current->fiber;
+    if (!fiber->IsRunning()) {
+        return;
+    }
+
+    // Tasks from Parallel() yield to the mode, so only the mode's yields end
+    // its time slice
+    bool isMode = m_current == &m_modeContext;
+    if (isMode) {
+        m_bodyEndTime = Clock::now();
+    }
+    fiber->Suspend();
+    if (isMode) {
+        m_bodyStartTime = Clock::now();
+    }
+
+    if (m_cancelRequested) {
+        throw AutonomousCancelled{};
+    }
 }
 
-void AutonomousChooser::Return() {
-    m_awaitingAuton = false;
-    m_cond.notify_one();
+void AutonomousChooser::WaitUntil(wpi::function_ref<bool()> condition) {
+    Park({condition, [] {}, kNever});
 }
 
-void AutonomousChooser::AwaitStartAutonomous() {
-    {
-        std::scoped_lock lock{m_mutex};
-        fmt::print("{} autonomous\n", m_selectedChoice);
-        m_selectedAuton = &m_choices[m_selectedChoice];
+void AutonomousChooser::WaitFor(units::second_t duration) {
+    WaitFor(duration, [] {});
+}
+
+void AutonomousChooser::WaitFor(units::second_t duration,
+                                wpi::function_ref<void()> action) {
+    Park({[] { return false; }, action,
+          frc2::Timer::GetFPGATimestamp() + duration});
+}
+
+bool AutonomousChooser::WaitUntilWithTimeout(
+    wpi::function_ref<bool()> condition, units::second_t timeout) {
+    return Park(
+        {condition, [] {}, frc2::Timer::GetFPGATimestamp() + timeout});
+}
+
+size_t AutonomousChooser::Race(
+    std::initializer_list<wpi::function_ref<bool()>> conditions) {
+    if (conditions.size() == 0) {
+        throw std::invalid_argument{"Race() takes at least one condition"};
+    }
+
+    size_t winner = 0;
+    WaitUntil([&] {
+        for (winner = 0; winner < conditions.size(); ++winner) {
+            if (conditions.begin()[winner]()) {
+                return true;
+            }
+        }
+        return false;
+    });
+    return winner;
+}
+
+void AutonomousChooser::All(
+    std::initializer_list<wpi::function_ref<bool()>> conditions) {
+    if (conditions.size() > 64) {
+        throw std::invalid_argument{"All() takes at most 64 conditions"};
+    }
+
+    // Bit i is set once condition i has been met
+    uint64_t met = 0;
+    uint64_t allMet = conditions.size() == 64
+                          ? ~uint64_t{0}
+                          : (uint64_t{1} << conditions.size()) - 1;
+    WaitUntil([&] {
+        for (size_t i = 0; i < conditions.size(); ++i) {
+            if ((met & (uint64_t{1} << i)) == 0 && conditions.begin()[i]()) {
+                met |= uint64_t{1} << i;
+            }
+        }
+        return met == allMet;
+    });
+}
+
+void AutonomousChooser::Parallel(
+    std::initializer_list<wpi::function_ref<void()>> tasks) {
+    std::vector<Task*> children;
+    children.reserve(tasks.size());
+
+    auto parent = m_current;
+    try {
+        for (const auto& task : tasks) {
+            children.emplace_back(&AcquireTask(task));
+        }
+
+        // The tasks start in this tick. After that, this waits until one of
+        // their waits is over. Tasks which only yielded are ready every tick.
+        while (StepTasks(children)) {
+            Park({[&] {
+                      bool anyReady = false;
+                      for (auto child : children) {
+                          if (child->running && !child->ready) {
+                              child->ready = child->context.wait == nullptr ||
+                                             PollWait(*child->context.wait);
+                          }
+                          anyReady = anyReady || child->ready;
+                      }
+                      return anyReady;
+                  },
+                  [] {}, kNever},
+                 false);
+        }
+    } catch (...) {
+        m_current = parent;
+        CancelTasks(children);
+        throw;
+    }
+
+    for (auto child : children) {
+        child->inUse = false;
     }
+}
+
+void AutonomousChooser::AwaitStartAutonomous() {
+    // m_modes is immutable, so only the index needs to be synchronized
+    auto& selected = m_modes[m_selectedIndex.load(std::memory_order_relaxed)];
+
+    EndAutonomous();
+    m_handoffHistogram.Reset();
+    m_bodyHistogram.Reset();
+    m_dispatchedAuton = &selected.func;
+    m_cancelRequested = false;
+    RunTick();
 
-    m_awaitingAuton = true;
-    m_autonThread = std::thread{[=] {
-        m_autonLock.lock();
-        m_autonRunning = true;
-        (*m_selectedAuton)();
-        m_autonRunning = false;
-        Return();
-        m_autonLock.unlock();
-    }};
-    m_cond.wait(m_mainLock, [&] { return !m_awaitingAuton; });
+    // Printed after the first tick so it doesn't delay computing the mode's
+    // first commands. The caller sends them once this returns.
+    fmt::print("{} autonomous\n", selected.name);
 }
 
 void AutonomousChooser::AwaitRunAutonomous() {
-    if (m_autonRunning) {
-        m_awaitingAuton = true;
-        m_cond.notify_one();
-        m_cond.wait(m_mainLock, [&] { return !m_awaitingAuton; });
+    if (!m_autonRunning) {
+        return;
+    }
+
+    // A waiting mode is only resumed once its wait is over
+    if (m_modeContext.wait != nullptr && !PollWait(*m_modeContext.wait)) {
+        return;
     }
+
+    RunTick();
 }
 
 void AutonomousChooser::EndAutonomous() {
     if (m_autonRunning) {
-        m_awaitingAuton = true;
-        m_cond.notify_one();
-        m_cond.wait(m_mainLock, [&] { return !m_awaitingAuton; });
+        auto startTime = Clock::now();
+        m_cancelRequested = true;
+        m_autonFiber->Resume();
+        m_modeContext.wait = nullptr;
+        m_current = &m_modeContext;
+        std::chrono::duration<double, std::micro> endTime =
+            Clock::now() - startTime;
+        m_endUs = endTime.count();
+
+        if (m_autonRunning) {
+            fmt::print("Autonomous mode didn't exit when autonomous ended\n");
+            m_autonRunning = false;
+            m_autonFiber.reset();
+
+            // Tasks it forked may refer to its stack, so they're dropped too
+            for (auto& task : m_tasks) {
+                if (task->inUse) {
+                    *task = Task{};
+                }
+            }
+        }
+    }
+
+    StartWorker();
+}
+
+bool AutonomousChooser::Park(Wait wait, bool checkFirst) {
+    if (checkFirst && PollWait(wait)) {
+        return wait.met;
+    }
+
+    auto context = m_current;
+    context->wait = &wait;
+    YieldToMain();
+    context->wait = nullptr;
+
+    return wait.met;
+}
+
+bool AutonomousChooser::PollWait(Wait& wait) {
+    if (wait.condition()) {
+        wait.met = true;
+        return true;
+    }
+
+    // Reading the FPGA timestamp is a HAL call, so untimed waits skip it
+    if (wait.deadline < kNever &&
+        frc2::Timer::GetFPGATimestamp() >= wait.deadline) {
+        return true;
+    }
+
+    wait.action();
+    return false;
+}
+
+size_t AutonomousChooser::FindAutonomous(wpi::StringRef name) const {
+    auto mode = std::lower_bound(
+        m_modes.begin(), m_modes.end(), name,
+        [](const auto& mode, wpi::StringRef key) { return mode.name < key; });
+    if (mode == m_modes.end() || mode->name != name) {
+        return m_modes.size();
+    }
+    return mode - m_modes.begin();
+}
+
+AutonomousChooser::Task& AutonomousChooser::AcquireTask(
+    const wpi::function_ref<void()>& func) {
+    auto it = std::find_if(m_tasks.begin(), m_tasks.end(),
+                           [](const auto& task) { return !task->inUse; });
+    if (it == m_tasks.end()) {
+        it = m_tasks.emplace(m_tasks.end(), std::make_unique<Task>());
+    }
+
+    auto& task = **it;
+    if (task.fiber == nullptr || task.fiber->IsFinished()) {
+        task.fiber = std::make_unique<Fiber>([=, &task] { RunTask(task); });
+        task.context.fiber = task.fiber.get();
+
+        // Run to the loop's first Suspend()
+        task.fiber->Resume();
     }
-    if (m_autonThread.joinable()) {
-        m_autonThread.join();
+
+    task.func = &func;
+    task.inUse = true;
+    task.running = true;
+    task.ready = true;
+    return task;
+}
+
+bool AutonomousChooser::StepTasks(const std::vector<Task*>& tasks) {
+    auto parent = m_current;
+
+    bool anyRunning = false;
+    for (auto task : tasks) {
+        if (task->running && task->ready) {
+            task->ready = false;
+            m_current = &task->context;
+            task->fiber->Resume();
+            m_current = parent;
+        }
+        anyRunning = anyRunning || task->running;
+    }
+
+    return anyRunning;
+}
+
+void AutonomousChooser::CancelTasks(const std::vector<Task*>& tasks) {
+    auto parent = m_current;
+    bool cancelRequested = std::exchange(m_cancelRequested, true);
+
+    for (auto task : tasks) {
+        if (task->running) {
+            if (std::exchange(task->func, nullptr) != nullptr) {
+                // It never started
+                task->running = false;
+            } else if (!task->fiber->IsFinished()) {
+                m_current = &task->context;
+                try {
+                    task->fiber->Resume();
+                } catch (...) {
+                    // Another exception is already propagating
+                }
+                m_current = parent;
+            }
+        }
+
+        if (task->running) {
+            if (!task->fiber->IsFinished()) {
+                fmt::print("Autonomous task didn't exit when cancelled\n");
+            }
+            task->fiber.reset();
+        }
+
+        task->context.wait = nullptr;
+        task->inUse = false;
+        task->running = false;
+        task->ready = false;
+    }
+
+    m_cancelRequested = cancelRequested;
+}
+
+void AutonomousChooser::RunTask(Task& task) {
+    while (!m_exiting) {
+        if (auto func = std::exchange(task.func, nullptr)) {
+            try {
+                (*func)();
+            } catch (const AutonomousCancelled&) {
+                // The task was cancelled before it returned
+            }
+            task.context.wait = nullptr;
+            task.running = false;
+        }
+
+        task.fiber->Suspend();
+    }
+}
+
+void AutonomousChooser::RunTick() {
+    m_resumeTime = Clock::now();
+    m_autonFiber->Resume();
+    auto returnTime = Clock::now();
+
+    auto handoff =
+        (m_bodyStartTime - m_resumeTime) + (returnTime - m_bodyEndTime);
+    m_handoffHistogram.Record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(handoff).count());
+    m_bodyHistogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               m_bodyEndTime - m_bodyStartTime)
+                               .count());
+}
+
+void AutonomousChooser::StartWorker() {
+    if (m_autonFiber != nullptr && !m_autonFiber->IsFinished()) {
+        return;
+    }
+
+    m_autonFiber = std::make_unique<Fiber>([=] { RunWorker(); });
+    m_modeContext.fiber = m_autonFiber.get();
+    m_autonFiber->Resume();
+}
+
+void AutonomousChooser::RunWorker() {
+    PrefaultStack();
+
+    while (!m_exiting) {
+        if (auto auton = std::exchange(m_dispatchedAuton, nullptr)) {
+            m_autonRunning = true;
+            m_bodyStartTime = Clock::now();
+            try {
+                (*auton)();
+            } catch (const AutonomousCancelled&) {
+                // Autonomous ended before the mode returned
+            } catch (...) {
+                // The exception is rethrown from Resume() and a new worker is
+                // started by the next EndAutonomous()
+                m_autonRunning = false;
+                throw;
+            }
+            m_bodyEndTime = Clock::now();
+            m_autonRunning = false;
+        }
+
+        m_autonFiber->Suspend();
     }
 }
 
 void AutonomousChooser::InitSendable(frc::SendableBuilder& builder) {
     builder.SetSmartDashboardType("String Chooser");
 
-    builder.GetEntry("default").SetString(m_defaultChoice);
+    const auto& defaultName = m_modes[m_defaultIndex].name;
+    builder.GetEntry("default").SetString(defaultName);
 
     m_optionsEntry = builder.GetEntry("options");
     m_optionsEntry.SetStringArray(m_names);
 
     m_selectedEntry = builder.GetEntry("selected");
-    m_selectedEntry.SetString(m_defaultChoice);
+    m_selectedEntry.SetString(defaultName);
 
     m_activeEntry = builder.GetEntry("active");
-    m_activeEntry.SetString(m_defaultChoice);
+    m_activeEntry.SetString(defaultName);
+
+    // The getters run on the main robot thread, which also records the
+    // samples, so they don't need locking
+    builder.AddDoubleArrayProperty(
+        "handoff histogram",
+        [=] { return m_handoffHistogram.GetBucketsAsDoubles(); }, nullptr);
+    builder.AddDoubleProperty(
+        "handoff last us", [=] { return m_handoffHistogram.GetLastUs(); },
+        nullptr);
+    builder.AddDoubleProperty(
+        "handoff max us", [=] { return m_handoffHistogram.GetMaxUs(); },
+        nullptr);
+    builder.AddDoubleArrayProperty(
+        "body histogram", [=] { return m_bodyHistogram.GetBucketsAsDoubles(); },
+        nullptr);
+    builder.AddDoubleProperty(
+        "body last us", [=] { return m_bodyHistogram.GetLastUs(); }, nullptr);
+    builder.AddDoubleProperty(
+        "body max us", [=] { return m_bodyHistogram.GetMaxUs(); }, nullptr);
+    builder.AddDoubleProperty("end us", [=] { return m_endUs; }, nullptr);
 }
 
 }  // namespace frc3512
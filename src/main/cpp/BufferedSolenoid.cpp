@@ -0,0 +1,19 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "BufferedSolenoid.hpp"
+
+BufferedSolenoid::BufferedSolenoid(int channel)
+    : m_solenoid{channel},
+      m_state{m_solenoid.Get()},
+      m_sentState{m_state} {}
+
+void BufferedSolenoid::Set(bool on) { m_state = on; }
+
+bool BufferedSolenoid::Get() const { return m_state; }
+
+void BufferedSolenoid::Flush() {
+    if (m_state != m_sentState) {
+        m_solenoid.Set(m_state);
+        m_sentState = m_state;
+    }
+}
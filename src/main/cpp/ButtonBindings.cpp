@@ -0,0 +1,307 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "ButtonBindings.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+
+#include <fmt/core.h>
+#include <wpi/json.h>
+#include <wpi/raw_istream.h>
+
+#include "subsystems/Elevator.hpp"
+
+namespace {
+
+enum class TriggerKind { kPressed, kReleased, kPOV, kAxis };
+
+// A binding before it's placed in the table
+struct PendingBinding {
+    size_t stick;
+    TriggerKind kind;
+    size_t input;
+    ButtonBindings::Binding binding;
+};
+
+struct ActionName {
+    const char* name;
+    ButtonBindings::Action action;
+};
+
+constexpr ActionName kActionNames[] = {
+    {"toggleElevatorGrab", ButtonBindings::Action::kToggleElevatorGrab},
+    {"toggleIntakeGrab", ButtonBindings::Action::kToggleIntakeGrab},
+    {"toggleIntakeStow", ButtonBindings::Action::kToggleIntakeStow},
+    {"toggleContainerGrab", ButtonBindings::Action::kToggleContainerGrab},
+    {"toggleManualMode", ButtonBindings::Action::kToggleManualMode},
+    {"stackTotes", ButtonBindings::Action::kStackTotes},
+    {"height", ButtonBindings::Action::kSetHeight}};
+
+// Returns the index of a POV angle in StickIndex::pov, or -1 if the angle
+// isn't centered or a multiple of 45 degrees
+int POVSlot(int angle) {
+    if (angle == -1) {
+        return 0;
+    }
+    if (angle < 0 || angle >= 360 || angle % 45 != 0) {
+        return -1;
+    }
+    return angle / 45 + 1;
+}
+
+int CountTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+// Returns an integer member of a binding in [min, max]
+int GetInt(const wpi::json& json, const char* key, int min, int max) {
+    int value = json.at(key).get<int>();
+    if (value < min || value > max) {
+        throw std::invalid_argument{fmt::format(
+            "\"{}\" is {}, not between {} and {}", key, value, min, max)};
+    }
+    return value;
+}
+
+PendingBinding CompileBinding(const wpi::json& json) {
+    using Action = ButtonBindings::Action;
+
+    if (!json.is_object()) {
+        throw std::invalid_argument{"isn't an object"};
+    }
+
+    PendingBinding pending{};
+    pending.stick = GetInt(json, "stick", 0, ButtonBindings::kMaxSticks - 1);
+
+    size_t triggers = json.count("button") + json.count("pov") +
+                      json.count("axis");
+    if (triggers != 1) {
+        throw std::invalid_argument{
+            "expected exactly one of \"button\", \"pov\", or \"axis\""};
+    }
+
+    if (json.count("button")) {
+        pending.input = GetInt(json, "button", 1, 32) - 1;
+        auto on = json.value("on", std::string{"press"});
+        if (on == "press") {
+            pending.kind = TriggerKind::kPressed;
+        } else if (on == "release") {
+            pending.kind = TriggerKind::kReleased;
+        } else {
+            throw std::invalid_argument{fmt::format(
+                "expected \"on\" to be \"press\" or \"release\", got \"{}\"",
+                on)};
+        }
+    } else if (json.count("pov")) {
+        int angle = json.at("pov").get<int>();
+        int slot = POVSlot(angle);
+        if (slot < 0) {
+            throw std::invalid_argument{fmt::format(
+                "POV angle {} isn't -1 or a multiple of 45 under 360", angle)};
+        }
+        pending.kind = TriggerKind::kPOV;
+        pending.input = slot;
+    } else {
+        pending.kind = TriggerKind::kAxis;
+        pending.input = GetInt(json, "axis", 0, HAL_kMaxJoystickAxes - 1);
+        if (json.count("above") + json.count("below") != 1) {
+            throw std::invalid_argument{
+                "expected exactly one of \"above\" or \"below\""};
+        }
+        pending.binding.above = json.count("above") != 0;
+        pending.binding.threshold =
+            json.at(pending.binding.above ? "above" : "below").get<float>();
+    }
+
+    auto name = json.at("action").get<std::string>();
+    auto action =
+        std::find_if(std::begin(kActionNames), std::end(kActionNames),
+                     [&](const auto& entry) { return name == entry.name; });
+    if (action == std::end(kActionNames)) {
+        throw std::invalid_argument{fmt::format("unknown action '{}'", name)};
+    }
+    pending.binding.action = action->action;
+
+    if (pending.binding.action == Action::kSetHeight) {
+        auto preset = json.at("height").get<std::string>();
+        auto height = Elevator::FindHeightPreset(preset);
+        if (!height) {
+            throw std::invalid_argument{
+                fmt::format("unknown height '{}'", preset)};
+        }
+        pending.binding.height = height->to<float>();
+    }
+
+    return pending;
+}
+
+}  // namespace
+
+ButtonBindings::ButtonBindings(wpi::StringRef json) {
+    wpi::json document;
+    try {
+        document = wpi::json::parse(json);
+    } catch (const wpi::json::exception& e) {
+        throw std::invalid_argument{e.what()};
+    }
+    Compile(document);
+}
+
+ButtonBindings ButtonBindings::Load(wpi::StringRef path) {
+    std::error_code ec;
+    wpi::raw_fd_istream input{path, ec};
+    if (ec) {
+        throw std::invalid_argument{
+            fmt::format("Failed to open {}: {}", path.str(), ec.message())};
+    }
+
+    ButtonBindings bindings;
+    try {
+        bindings.Compile(wpi::json::parse(input));
+    } catch (const wpi::json::exception& e) {
+        throw std::invalid_argument{e.what()};
+    }
+    return bindings;
+}
+
+void ButtonBindings::Evaluate(wpi::ArrayRef<const JoystickSnapshot*> sticks,
+                              wpi::function_ref<void(const Binding&)> run) {
+    auto runRange = [&](const Range& range) {
+        for (size_t i = range.begin; i < range.end; ++i) {
+            run(m_bindings[i]);
+        }
+    };
+
+    for (size_t port = 0; port < sticks.size() && port < kMaxSticks; ++port) {
+        if (sticks[port] == nullptr) {
+            continue;
+        }
+        const auto& stick = *sticks[port];
+        const auto& index = m_sticks[port];
+
+        // Only the inputs that changed are visited
+        for (uint32_t mask = stick.pressed; mask != 0; mask &= mask - 1) {
+            runRange(index.pressed[CountTrailingZeros(mask)]);
+        }
+        for (uint32_t mask = stick.released; mask != 0; mask &= mask - 1) {
+            runRange(index.released[CountTrailingZeros(mask)]);
+        }
+        if (stick.povChanged) {
+            int slot = POVSlot(stick.pov);
+            if (slot >= 0) {
+                runRange(index.pov[slot]);
+            }
+        }
+        for (uint32_t mask = stick.axesChanged & index.boundAxes; mask != 0;
+             mask &= mask - 1) {
+            int axis = CountTrailingZeros(mask);
+            EvaluateAxis(index.axes[axis], stick.axes[axis], &run);
+        }
+    }
+}
+
+void ButtonBindings::Prime(wpi::ArrayRef<const JoystickSnapshot*> sticks) {
+    for (size_t port = 0; port < sticks.size() && port < kMaxSticks; ++port) {
+        if (sticks[port] == nullptr) {
+            continue;
+        }
+        const auto& stick = *sticks[port];
+        const auto& index = m_sticks[port];
+
+        for (uint32_t mask = index.boundAxes; mask != 0; mask &= mask - 1) {
+            int axis = CountTrailingZeros(mask);
+            EvaluateAxis(index.axes[axis], stick.axes[axis], nullptr);
+        }
+    }
+}
+
+void ButtonBindings::EvaluateAxis(
+    const Range& range, float value,
+    wpi::function_ref<void(const Binding&)>* run) {
+    for (size_t i = range.begin; i < range.end; ++i) {
+        const auto& binding = m_bindings[i];
+        bool active = binding.above ? value > binding.threshold
+                                    : value < binding.threshold;
+        if (active && !m_axisActive[i] && run != nullptr) {
+            (*run)(binding);
+        }
+        m_axisActive[i] = active;
+    }
+}
+
+void ButtonBindings::Compile(const wpi::json& document) {
+    auto list = document.find("bindings");
+    if (!document.is_object() || list == document.end() ||
+        !list->is_array()) {
+        throw std::invalid_argument{
+            "expected an object with a \"bindings\" array"};
+    }
+
+    std::vector<PendingBinding> pending;
+    for (size_t i = 0; i < list->size(); ++i) {
+        try {
+            pending.emplace_back(CompileBinding((*list)[i]));
+        } catch (const std::exception& e) {
+            throw std::invalid_argument{
+                fmt::format("binding {}: {}", i, e.what())};
+        }
+    }
+    if (pending.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::invalid_argument{"too many bindings"};
+    }
+
+    // Groups each trigger's bindings together, keeping their order in the
+    // file
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const auto& lhs, const auto& rhs) {
+                         return std::tie(lhs.stick, lhs.kind, lhs.input) <
+                                std::tie(rhs.stick, rhs.kind, rhs.input);
+                     });
+
+    m_bindings.clear();
+    m_sticks = {};
+    for (const auto& binding : pending) {
+        auto& index = m_sticks[binding.stick];
+
+        Range* range = nullptr;
+        switch (binding.kind) {
+            case TriggerKind::kPressed:
+                range = &index.pressed[binding.input];
+                break;
+            case TriggerKind::kReleased:
+                range = &index.released[binding.input];
+                break;
+            case TriggerKind::kPOV:
+                range = &index.pov[binding.input];
+                break;
+            case TriggerKind::kAxis:
+                range = &index.axes[binding.input];
+                index.boundAxes |= uint32_t{1} << binding.input;
+                break;
+        }
+
+        uint16_t position = static_cast<uint16_t>(m_bindings.size());
+        if (range->begin == range->end) {
+            range->begin = position;
+        }
+        range->end = position + 1;
+
+        m_bindings.emplace_back(binding.binding);
+    }
+    m_axisActive.assign(m_bindings.size(), false);
+}
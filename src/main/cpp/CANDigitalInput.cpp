@@ -1,9 +1,23 @@
-// Copyright (c) 2020 FRC Team 3512. All Rights Reserved.
+// Copyright (c) 2020-2021 FRC Team 3512. All Rights Reserved.
 
 #include "CANDigitalInput.hpp"
 
 CANDigitalInput::CANDigitalInput(
     ctre::phoenix::motorcontrol::can::TalonSRX& motor)
-    : m_motor(motor) {}
+    : m_motor(motor), m_simDevice{"CANDigitalInput", motor.GetDeviceID()} {
+    if (m_simDevice) {
+        m_simValue = m_simDevice.CreateBoolean("value", false, false);
+    }
 
-bool CANDigitalInput::Get() { return m_sensor.IsRevLimitSwitchClosed(); }
+    Sample();
+}
+
+void CANDigitalInput::Sample() {
+    if (m_simValue) {
+        m_value = m_simValue.Get();
+    } else {
+        m_value = m_sensor.IsRevLimitSwitchClosed();
+    }
+}
+
+bool CANDigitalInput::Get() const { return m_value; }
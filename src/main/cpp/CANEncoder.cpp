@@ -2,26 +2,96 @@
 
 #include "CANEncoder.hpp"
 
+#include <stdint.h>
+
+#include <algorithm>
+
 #include <ctre/phoenix/motorcontrol/FeedbackDevice.h>
+#include <frc2/Timer.h>
 
 CANEncoder::CANEncoder(ctre::phoenix::motorcontrol::can::TalonSRX& motor,
                        double distancePerPulse, bool reverseDirection)
-    : m_motor{motor}, m_distancePerPulse{distancePerPulse} {
+    : m_motor{motor},
+      m_distancePerPulse{distancePerPulse},
+      m_simDevice{"CANEncoder", motor.GetDeviceID()} {
+    if (m_simDevice) {
+        m_simDistance = m_simDevice.CreateDouble("distance", false, 0.0);
+        m_simRate = m_simDevice.CreateDouble("rate", false, 0.0);
+    }
+
     motor.ConfigSelectedFeedbackSensor(
         ctre::phoenix::motorcontrol::FeedbackDevice::QuadEncoder, 0, 0);
     motor.SetSensorPhase(reverseDirection);
-}
 
-double CANEncoder::GetDistance() {
-    return m_motor.GetSensorCollection().GetQuadraturePosition() *
-           m_distancePerPulse;
+    Sample();
 }
 
-double CANEncoder::GetRate() {
-    return m_motor.GetSensorCollection().GetQuadratureVelocity() *
-           m_distancePerPulse;
+void CANEncoder::Sample() {
+    auto now = frc2::Timer::GetFPGATimestamp();
+    auto elapsed = now - m_sample.timestamp;
+    m_sample.timestamp = now;
+
+    if (m_simDistance) {
+        m_sample.distance = m_simDistance.Get();
+        m_sample.rate = m_simRate.Get();
+        m_sample.age = 0_s;
+    } else {
+        auto& sensors = m_motor.GetSensorCollection();
+        int position = sensors.GetQuadraturePosition();
+        int velocity = sensors.GetQuadratureVelocity();
+
+        // If the encoder is at rest, the last frame is still current no
+        // matter when it arrived
+        if (position != m_lastPosition || velocity != m_lastVelocity ||
+            velocity == 0) {
+            m_sample.age =
+                std::min(units::second_t{kStatusFramePeriod}, elapsed) / 2.0;
+        } else {
+            m_sample.age += elapsed;
+        }
+        m_sample.stale = m_sample.age > kMaxAge;
+        m_lastPosition = position;
+        m_lastVelocity = velocity;
+
+        m_sample.distance = position * m_distancePerPulse;
+
+        // The Talon measures velocity in pulses per 100 ms
+        m_sample.rate = velocity * m_distancePerPulse * 10.0;
+    }
+
+    m_ageHistogram.Record(
+        static_cast<int64_t>(m_sample.age.to<double>() * 1e9));
 }
 
+double CANEncoder::GetDistance() const { return m_sample.distance; }
+
+double CANEncoder::GetRate() const { return m_sample.rate; }
+
 void CANEncoder::Reset() {
+    if (m_simDistance) {
+        m_simDistance.Set(0.0);
+    }
     m_motor.GetSensorCollection().SetQuadraturePosition(0);
+
+    // Readers later in the tick see the reset without waiting for a sample
+    m_sample.distance = 0.0;
+}
+
+void CANEncoder::InitSendable(frc::SendableBuilder& builder) {
+    builder.SetSmartDashboardType("Encoder");
+
+    // The getters run on the main robot thread, which also takes the samples,
+    // so they don't need locking
+    builder.AddDoubleProperty(
+        "Distance", [=] { return m_sample.distance; }, nullptr);
+    builder.AddDoubleProperty("Speed", [=] { return m_sample.rate; }, nullptr);
+    builder.AddDoubleArrayProperty(
+        "age histogram", [=] { return m_ageHistogram.GetBucketsAsDoubles(); },
+        nullptr);
+    builder.AddDoubleProperty(
+        "age last us", [=] { return m_ageHistogram.GetLastUs(); }, nullptr);
+    builder.AddDoubleProperty(
+        "age mean us", [=] { return m_ageHistogram.GetMeanUs(); }, nullptr);
+    builder.AddDoubleProperty(
+        "age max us", [=] { return m_ageHistogram.GetMaxUs(); }, nullptr);
 }
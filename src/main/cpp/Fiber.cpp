@@ -0,0 +1,408 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Fiber.hpp"
+
+#include <errno.h>
+#include <stdint.h>
+
+#include <new>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#define FIBER_WINDOWS
+#include <windows.h>
+#elif defined(__x86_64__) || (defined(__arm__) && !defined(__aarch64__))
+#define FIBER_ASM
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define FIBER_UCONTEXT
+// macOS deprecates ucontext, but it's still the portable fallback
+#define _XOPEN_SOURCE 700
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#include <sanitizer/common_interface_defs.h>
+#define FIBER_ASAN
+#endif
+
+namespace frc3512 {
+
+// Calls the private Fiber::Main() from the platform's entry point
+struct FiberEntry {
+    [[noreturn]] static void Run(void* fiber) {
+        Fiber::Main(static_cast<Fiber*>(fiber));
+    }
+};
+
+#if defined(FIBER_ASM)
+
+#ifdef __APPLE__
+#define FIBER_SYMBOL(name) "_" #name
+#define FIBER_FUNCTION(name) ".globl _" #name "\n_" #name ":\n"
+#define FIBER_CALL(name) "_" #name
+#else
+#define FIBER_SYMBOL(name) #name
+#define FIBER_FUNCTION(name) \
+    ".globl " #name "\n.type " #name ", %function\n" #name ":\n"
+#define FIBER_CALL(name) #name "@PLT"
+#endif
+
+extern "C" {
+
+/**
+ * Saves the callee-saved registers on the current stack, stores the stack
+ * pointer in *saveSp, then switches to the stack at newSp and restores the
+ * registers saved there.
+ */
+void frc3512_SwitchFiberContext(void** saveSp, void* newSp);
+
+// The first "return address" of a new fiber. Calls frc3512_FiberMain().
+void frc3512_FiberTrampoline();
+
+[[noreturn]] void frc3512_FiberMain(void* fiber) { FiberEntry::Run(fiber); }
+
+}  // extern "C"
+
+#if defined(__x86_64__)
+
+// System V ABI: rbx, rbp, and r12-r15 are callee-saved, as are the x87 control
+// word and MXCSR control bits
+asm(".text\n"
+    ".p2align 4\n" FIBER_FUNCTION(frc3512_SwitchFiberContext)
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".p2align 4\n" FIBER_FUNCTION(frc3512_FiberTrampoline)
+    "    movq %r12, %rdi\n"
+    "    call " FIBER_CALL(frc3512_FiberMain) "\n"
+    "    ud2\n");
+
+namespace {
+
+// Registers popped by frc3512_SwitchFiberContext(), from the lowest address
+struct InitialFrame {
+    uint32_t mxcsr;
+    uint16_t x87ControlWord;
+    uint16_t padding;
+    void* r15;
+    void* r14;
+    void* r13;
+    void* r12;
+    void* rbx;
+    void* rbp;
+    void (*returnAddress)();
+};
+
+void FillInitialFrame(InitialFrame& frame, void* fiber) {
+    frame.mxcsr = 0x1F80;
+    frame.x87ControlWord = 0x037F;
+    frame.r12 = fiber;
+    frame.returnAddress = frc3512_FiberTrampoline;
+}
+
+}  // namespace
+
+#else  // ARM
+
+// AAPCS: r4-r11 and d8-d15 are callee-saved. r12 is saved too to keep the
+// stack 8-byte aligned.
+asm(".text\n"
+    ".arm\n"
+    ".p2align 2\n" FIBER_FUNCTION(frc3512_SwitchFiberContext)
+    "    push {r4-r12, lr}\n"
+#if defined(__ARM_FP)
+    "    vpush {d8-d15}\n"
+#endif
+    "    str sp, [r0]\n"
+    "    mov sp, r1\n"
+#if defined(__ARM_FP)
+    "    vpop {d8-d15}\n"
+#endif
+    "    pop {r4-r12, lr}\n"
+    "    bx lr\n"
+    ".p2align 2\n" FIBER_FUNCTION(frc3512_FiberTrampoline)
+    "    mov r0, r4\n"
+    "    bl " FIBER_SYMBOL(frc3512_FiberMain) "\n"
+    "    bkpt #0\n"
+#if defined(__thumb__)
+    ".thumb\n"
+#endif
+);
+
+namespace {
+
+// Registers popped by frc3512_SwitchFiberContext(), from the lowest address
+struct InitialFrame {
+#if defined(__ARM_FP)
+    double d[8];
+#endif
+    void* r4;
+    void* r5to12[8];
+    void (*lr)();
+};
+
+void FillInitialFrame(InitialFrame& frame, void* fiber) {
+    frame.r4 = fiber;
+    frame.lr = frc3512_FiberTrampoline;
+}
+
+}  // namespace
+
+#endif  // __x86_64__
+
+struct Fiber::Context {
+    void* stack = nullptr;
+    size_t mappedSize = 0;
+    void* fiberSp = nullptr;
+    void* callerSp = nullptr;
+
+#if defined(FIBER_ASAN)
+    const void* stackBottom = nullptr;
+    size_t stackSize = 0;
+    const void* callerBottom = nullptr;
+    size_t callerSize = 0;
+#endif
+};
+
+#elif defined(FIBER_WINDOWS)
+
+struct Fiber::Context {
+    LPVOID fiber = nullptr;
+    LPVOID caller = nullptr;
+};
+
+namespace {
+
+void CALLBACK FiberProc(LPVOID fiber) { FiberEntry::Run(fiber); }
+
+}  // namespace
+
+#else  // FIBER_UCONTEXT
+
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+#elif defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+
+struct Fiber::Context {
+    void* stack = nullptr;
+    size_t mappedSize = 0;
+    ucontext_t fiber;
+    ucontext_t caller;
+
+#if defined(FIBER_ASAN)
+    const void* stackBottom = nullptr;
+    size_t stackSize = 0;
+    const void* callerBottom = nullptr;
+    size_t callerSize = 0;
+#endif
+};
+
+namespace {
+
+// makecontext() can only pass int arguments, so the fiber being started is
+// passed through here
+thread_local Fiber* t_startingFiber = nullptr;
+
+void UcontextEntry() { FiberEntry::Run(t_startingFiber); }
+
+}  // namespace
+
+#endif
+
+#if defined(FIBER_ASM) || defined(FIBER_UCONTEXT)
+
+namespace {
+
+/**
+ * Maps a stack with an inaccessible guard page below it, so overflowing the
+ * stack crashes instead of corrupting memory.
+ *
+ * @return Lowest address of the stack above the guard page.
+ */
+void* MapStack(size_t& stackSize, void*& mapping, size_t& mappedSize) {
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    stackSize = (stackSize + pageSize - 1) / pageSize * pageSize;
+    mappedSize = stackSize + pageSize;
+
+    mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::system_error{errno, std::generic_category(),
+                                "Failed to map fiber stack"};
+    }
+    mprotect(mapping, pageSize, PROT_NONE);
+
+    return static_cast<char*>(mapping) + pageSize;
+}
+
+}  // namespace
+
+#endif
+
+Fiber::Fiber(std::function<void()> func, size_t stackSize)
+    : m_func{std::move(func)}, m_context{std::make_unique<Context>()} {
+#if defined(FIBER_WINDOWS)
+    m_context->fiber = CreateFiber(stackSize, FiberProc, this);
+    if (m_context->fiber == nullptr) {
+        throw std::system_error{static_cast<int>(GetLastError()),
+                                std::system_category(),
+                                "Failed to create fiber"};
+    }
+#else
+    void* bottom =
+        MapStack(stackSize, m_context->stack, m_context->mappedSize);
+
+#if defined(FIBER_ASAN)
+    m_context->stackBottom = bottom;
+    m_context->stackSize = stackSize;
+#endif
+
+#if defined(FIBER_ASM)
+    /* With the frame 16-byte aligned, the stack pointer is aligned as the ABI
+     * requires when the trampoline calls frc3512_FiberMain()
+     */
+    auto top = reinterpret_cast<uintptr_t>(bottom) + stackSize;
+    auto frameAddress = (top - sizeof(InitialFrame)) & ~uintptr_t{15};
+
+    auto frame = new (reinterpret_cast<void*>(frameAddress)) InitialFrame{};
+    FillInitialFrame(*frame, this);
+    m_context->fiberSp = frame;
+#else
+    getcontext(&m_context->fiber);
+    m_context->fiber.uc_stack.ss_sp = bottom;
+    m_context->fiber.uc_stack.ss_size = stackSize;
+    m_context->fiber.uc_link = nullptr;
+    makecontext(&m_context->fiber, UcontextEntry, 0);
+#endif
+#endif
+}
+
+Fiber::~Fiber() {
+#if defined(FIBER_WINDOWS)
+    DeleteFiber(m_context->fiber);
+#else
+#if defined(FIBER_ASAN)
+    // Frames left on the stack are still poisoned, and the shadow memory
+    // outlives the mapping, so a new stack mapped at the same address would
+    // start out poisoned
+    __asan_unpoison_memory_region(m_context->stackBottom,
+                                  m_context->stackSize);
+#endif
+    munmap(m_context->stack, m_context->mappedSize);
+#endif
+}
+
+void Fiber::Resume() {
+    if (m_finished || m_running) {
+        return;
+    }
+
+    m_running = true;
+    SwitchIn();
+    m_running = false;
+
+    if (m_exception) {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
+
+void Fiber::Suspend() { SwitchOut(); }
+
+void Fiber::SwitchIn() {
+#if defined(FIBER_WINDOWS)
+    if (!IsThreadAFiber()) {
+        ConvertThreadToFiber(nullptr);
+    }
+    m_context->caller = GetCurrentFiber();
+    SwitchToFiber(m_context->fiber);
+#else
+#if defined(FIBER_ASAN)
+    void* fakeStack = nullptr;
+    __sanitizer_start_switch_fiber(&fakeStack, m_context->stackBottom,
+                                   m_context->stackSize);
+#endif
+
+#if defined(FIBER_ASM)
+    frc3512_SwitchFiberContext(&m_context->callerSp, m_context->fiberSp);
+#else
+    t_startingFiber = this;
+    swapcontext(&m_context->caller, &m_context->fiber);
+#endif
+
+#if defined(FIBER_ASAN)
+    __sanitizer_finish_switch_fiber(fakeStack, nullptr, nullptr);
+#endif
+#endif
+}
+
+void Fiber::SwitchOut() {
+#if defined(FIBER_WINDOWS)
+    SwitchToFiber(m_context->caller);
+#else
+#if defined(FIBER_ASAN)
+    // A finished fiber's fake stack is freed instead of saved
+    void* fakeStack = nullptr;
+    __sanitizer_start_switch_fiber(m_finished ? nullptr : &fakeStack,
+                                   m_context->callerBottom,
+                                   m_context->callerSize);
+#endif
+
+#if defined(FIBER_ASM)
+    frc3512_SwitchFiberContext(&m_context->fiberSp, m_context->callerSp);
+#else
+    swapcontext(&m_context->fiber, &m_context->caller);
+#endif
+
+#if defined(FIBER_ASAN)
+    __sanitizer_finish_switch_fiber(fakeStack, &m_context->callerBottom,
+                                    &m_context->callerSize);
+#endif
+#endif
+}
+
+void Fiber::Main(Fiber* fiber) {
+#if defined(FIBER_ASAN)
+    __sanitizer_finish_switch_fiber(nullptr, &fiber->m_context->callerBottom,
+                                    &fiber->m_context->callerSize);
+#endif
+
+    try {
+        fiber->m_func();
+    } catch (...) {
+        fiber->m_exception = std::current_exception();
+    }
+
+    fiber->m_finished = true;
+    fiber->SwitchOut();
+
+    // A finished fiber is never resumed
+    std::terminate();
+}
+
+}  // namespace frc3512
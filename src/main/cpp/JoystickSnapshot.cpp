@@ -0,0 +1,85 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "JoystickSnapshot.hpp"
+
+#include <stddef.h>
+
+#include <frc/Joystick.h>
+#include <hal/DriverStation.h>
+
+namespace {
+
+// Returns the mask bit of a button, or 0 if there's no such button
+uint32_t ButtonMask(int button) {
+    if (button < 1 || button > 32) {
+        return 0;
+    }
+    return uint32_t{1} << (button - 1);
+}
+
+}  // namespace
+
+JoystickSnapshot JoystickSnapshot::Read(int port,
+                                        const JoystickSnapshot& last) {
+    JoystickSnapshot snapshot;
+
+    HAL_JoystickAxes axes;
+    HAL_GetJoystickAxes(port, &axes);
+    for (int i = 0; i < axes.count && i < HAL_kMaxJoystickAxes; ++i) {
+        snapshot.axes[i] = axes.axes[i];
+    }
+
+    HAL_JoystickButtons buttons;
+    HAL_GetJoystickButtons(port, &buttons);
+    snapshot.buttons = buttons.buttons;
+
+    HAL_JoystickPOVs povs;
+    HAL_GetJoystickPOVs(port, &povs);
+    if (povs.count > 0) {
+        snapshot.pov = povs.povs[0];
+    }
+
+    snapshot.FindChanges(last);
+    return snapshot;
+}
+
+void JoystickSnapshot::FindChanges(const JoystickSnapshot& last) {
+    pressed = buttons & ~last.buttons;
+    released = ~buttons & last.buttons;
+
+    axesChanged = 0;
+    for (size_t i = 0; i < axes.size(); ++i) {
+        if (axes[i] != last.axes[i]) {
+            axesChanged |= uint32_t{1} << i;
+        }
+    }
+
+    povChanged = pov != last.pov;
+}
+
+double JoystickSnapshot::GetX() const {
+    return GetRawAxis(frc::Joystick::kDefaultXChannel);
+}
+
+double JoystickSnapshot::GetY() const {
+    return GetRawAxis(frc::Joystick::kDefaultYChannel);
+}
+
+double JoystickSnapshot::GetRawAxis(int axis) const {
+    if (axis < 0 || axis >= HAL_kMaxJoystickAxes) {
+        return 0.0;
+    }
+    return axes[axis];
+}
+
+bool JoystickSnapshot::GetRawButton(int button) const {
+    return buttons & ButtonMask(button);
+}
+
+bool JoystickSnapshot::GetRawButtonPressed(int button) const {
+    return pressed & ButtonMask(button);
+}
+
+bool JoystickSnapshot::GetRawButtonReleased(int button) const {
+    return released & ButtonMask(button);
+}
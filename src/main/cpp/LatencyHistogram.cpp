@@ -0,0 +1,38 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "LatencyHistogram.hpp"
+
+void LatencyHistogram::Record(int64_t nanoseconds) {
+    if (nanoseconds < 0) {
+        nanoseconds = 0;
+    }
+
+    // The bucket is the bit length of the whole number of microseconds
+    uint64_t us = static_cast<uint64_t>(nanoseconds) / 1000;
+    size_t bucket = 0;
+    while (us != 0 && bucket < kBuckets - 1) {
+        us >>= 1;
+        ++bucket;
+    }
+
+    ++m_buckets[bucket];
+    ++m_count;
+    m_lastNs = nanoseconds;
+    if (nanoseconds > m_maxNs) {
+        m_maxNs = nanoseconds;
+    }
+    m_totalNs += nanoseconds;
+}
+
+void LatencyHistogram::Reset() { *this = LatencyHistogram{}; }
+
+std::vector<double> LatencyHistogram::GetBucketsAsDoubles() const {
+    return std::vector<double>(m_buckets.begin(), m_buckets.end());
+}
+
+double LatencyHistogram::GetMeanUs() const {
+    if (m_count == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(m_totalNs) / m_count / 1e3;
+}
@@ -2,95 +2,225 @@
 
 #include "Robot.hpp"
 
+#include <algorithm>
+
+#include <fmt/core.h>
+#include <frc/DriverStation.h>
+#include <frc/Filesystem.h>
+#include <wpi/Path.h>
+#include <wpi/SmallString.h>
+
+namespace {
+
+// The bindings teleop falls back to if bindings.json can't be loaded. They're
+// the same as the shipped file.
+constexpr const char* kDefaultBindings = R"({
+    "bindings": [
+        {"stick": 2, "button": 1, "action": "toggleElevatorGrab"},
+        {"stick": 2, "button": 2, "action": "toggleIntakeGrab"},
+        {"stick": 2, "button": 3, "action": "stackTotes"},
+        {"stick": 2, "button": 4, "action": "toggleManualMode"},
+        {"stick": 2, "button": 5, "action": "toggleIntakeStow"},
+        {"stick": 2, "button": 6, "action": "toggleContainerGrab"},
+
+        {"stick": 2, "button": 8, "action": "height", "height": "ground"},
+        {"stick": 2, "button": 7, "action": "height", "height": "tote1"},
+        {"stick": 2, "button": 10, "action": "height", "height": "tote2"},
+        {"stick": 2, "button": 9, "action": "height", "height": "tote3"},
+        {"stick": 2, "button": 12, "action": "height", "height": "tote4"},
+        {"stick": 2, "button": 11, "action": "height", "height": "tote5"}
+    ]
+})";
+
+}  // namespace
+
 Robot::Robot() {
-    autonChooser.AddAutonomous("DriveForward", [=] { AutoDriveForward(); });
-    autonChooser.AddAutonomous("ResetElevator", [=] { AutoResetElevator(); });
-    autonChooser.AddAutonomous("OneCanLeft", [=] { AutoOneCanLeft(); });
-    autonChooser.AddAutonomous("OneCanCenter", [=] { AutoOneCanCenter(); });
-    autonChooser.AddAutonomous("OneCanRight", [=] { AutoOneCanRight(); });
-    autonChooser.AddAutonomous("OneTote", [=] { AutoOneTote(); });
+    drivetrain.AddStatusFrames(statusFrames);
+    elevator.AddStatusFrames(statusFrames);
+    statusFrames.Apply();
+
+    traceLogger.AddTrace("AutoStack", elevator.GetAutoStackTrace());
+    traceLogger.Start();
+}
+
+void Robot::RobotPeriodic() { statusFrames.ReapplyIfReset(); }
+
+void Robot::DisabledInit() { autonChooser.EndAutonomous(); }
+
+void Robot::TeleopInit() {
+    // Init runs before the first Periodic of the mode, so it needs a fresh
+    // sample too
+    SampleSensors();
+    autonChooser.EndAutonomous();
+
+    // Buttons held when teleop starts aren't presses
+    inputs = ReadInputs();
+    bindings.Prime(
+        {&inputs.driveStick1, &inputs.driveStick2, &inputs.appendageStick});
+
+    // The intake may still be running from autonomous
+    elevator.SetIntakeDirection(GetIntakeDirection(inputs));
+
+    // Sent now rather than at the end of the first TeleopPeriodic()
+    FlushOutputs();
 }
 
 void Robot::TeleopPeriodic() {
-    drivetrain.Drive(driveStick1.GetY(), driveStick2.GetX(),
-                     driveStick2.GetRawButton(2));
+    SampleSensors();
+    inputs = ReadInputs();
+    RunTeleop(inputs);
+    FlushOutputs();
+}
 
-    // Open/close tines
-    if (appendageStick.GetRawButtonPressed(1)) {
-        elevator.ElevatorGrab(!elevator.IsElevatorGrabbed());
-    }
+void Robot::AutonomousInit() {
+    SampleSensors();
+    drivetrain.ResetEncoders();
+    autonChooser.AwaitStartAutonomous();
 
-    // Open/close intake
-    if (appendageStick.GetRawButtonPressed(2)) {
-        elevator.IntakeGrab(!elevator.IsIntakeGrabbed());
-    }
+    // The mode's first tick ran above, so its commands are sent now rather
+    // than at the end of the first AutonomousPeriodic()
+    FlushOutputs();
+}
 
-    // Start auto-stacking mode
-    if (appendageStick.GetRawButtonPressed(3)) {
-        elevator.StackTotes();
-    }
+void Robot::AutonomousPeriodic() {
+    SampleSensors();
+    autonChooser.AwaitRunAutonomous();
 
-    // Manual height control
-    if (appendageStick.GetRawButtonPressed(4)) {
-        elevator.SetManualMode(!elevator.IsManualMode());
-    }
+    elevator.UpdateState();
+    FlushOutputs();
+}
 
-    // Stow intake
-    if (appendageStick.GetRawButtonPressed(5)) {
-        elevator.StowIntake(!elevator.IsIntakeStowed());
-    }
+void Robot::RunTeleop(const Inputs& snapshot) {
+    const auto& [driveStick1, driveStick2, appendageStick] = snapshot;
 
-    // Open/close container grabber
-    if (appendageStick.GetRawButtonPressed(6)) {
-        elevator.ContainerGrab(!elevator.IsContainerGrabbed());
-    }
+    drivetrain.Drive(driveStick1.GetY(), driveStick2.GetX(),
+                     driveStick2.GetRawButton(2));
 
-    // Automatic preset buttons (7-12)
-    if (appendageStick.GetRawButtonPressed(8)) {
-        elevator.RaiseElevator(Elevator::kGroundHeight);
-    }
-    if (appendageStick.GetRawButtonPressed(7)) {
-        elevator.RaiseElevator(Elevator::kToteHeight1);
-    }
-    if (appendageStick.GetRawButtonPressed(10)) {
-        elevator.RaiseElevator(Elevator::kToteHeight2);
-    }
-    if (appendageStick.GetRawButtonPressed(9)) {
-        elevator.RaiseElevator(Elevator::kToteHeight3);
-    }
-    if (appendageStick.GetRawButtonPressed(12)) {
-        elevator.RaiseElevator(Elevator::kToteHeight4);
-    }
-    if (appendageStick.GetRawButtonPressed(11)) {
-        elevator.RaiseElevator(Elevator::kToteHeight5);
-    }
+    bindings.Evaluate({&driveStick1, &driveStick2, &appendageStick},
+                      [&](const auto& binding) { RunBinding(binding); });
 
     // Set manual value
     elevator.SetManualLiftSpeed(appendageStick.GetY() * 12_V);
 
     // Controls intake
-    if (driveStick2.GetPOV() == 0 || appendageStick.GetPOV() == 0) {
-        elevator.SetIntakeDirection(Elevator::S_FORWARD);
-    } else if (driveStick2.GetPOV() == 90 || appendageStick.GetPOV() == 90) {
-        elevator.SetIntakeDirection(Elevator::S_ROTATE_CCW);
-    } else if (driveStick2.GetPOV() == 180 || appendageStick.GetPOV() == 180 ||
+    elevator.SetIntakeDirection(GetIntakeDirection(snapshot));
+
+    elevator.UpdateState();
+}
+
+Elevator::IntakeMotorState Robot::GetIntakeDirection(const Inputs& snapshot) {
+    const auto& driveStick2 = snapshot.driveStick2;
+    int drivePOV = driveStick2.GetPOV();
+    int appendagePOV = snapshot.appendageStick.GetPOV();
+    if (drivePOV == 0 || appendagePOV == 0) {
+        return Elevator::S_FORWARD;
+    } else if (drivePOV == 90 || appendagePOV == 90) {
+        return Elevator::S_ROTATE_CCW;
+    } else if (drivePOV == 180 || appendagePOV == 180 ||
                driveStick2.GetRawButton(1)) {
-        elevator.SetIntakeDirection(Elevator::S_REVERSE);
-    } else if (driveStick2.GetPOV() == 270 || appendageStick.GetPOV() == 270) {
-        elevator.SetIntakeDirection(Elevator::S_ROTATE_CW);
+        return Elevator::S_REVERSE;
+    } else if (drivePOV == 270 || appendagePOV == 270) {
+        return Elevator::S_ROTATE_CW;
     } else {
-        elevator.SetIntakeDirection(Elevator::S_STOPPED);
+        return Elevator::S_STOPPED;
     }
+}
 
-    elevator.UpdateState();
+void Robot::SampleSensors() {
+    drivetrain.SampleSensors();
+    elevator.SampleSensors();
 }
 
-void Robot::AutonomousInit() { drivetrain.ResetEncoders(); }
+void Robot::FlushOutputs() {
+    drivetrain.FlushOutputs();
+    elevator.FlushOutputs();
+}
 
-void Robot::AutonomousPeriodic() {
-    autonChooser.AwaitRunAutonomous();
+Robot::Inputs Robot::ReadInputs() const {
+    return {JoystickSnapshot::Read(kDriveStick1Port, inputs.driveStick1),
+            JoystickSnapshot::Read(kDriveStick2Port, inputs.driveStick2),
+            JoystickSnapshot::Read(kAppendageStickPort, inputs.appendageStick)};
+}
 
-    elevator.UpdateState();
+void Robot::RunBinding(const ButtonBindings::Binding& binding) {
+    using Action = ButtonBindings::Action;
+
+    switch (binding.action) {
+        case Action::kToggleElevatorGrab:
+            elevator.ElevatorGrab(!elevator.IsElevatorGrabbed());
+            break;
+        case Action::kToggleIntakeGrab:
+            elevator.IntakeGrab(!elevator.IsIntakeGrabbed());
+            break;
+        case Action::kToggleIntakeStow:
+            elevator.StowIntake(!elevator.IsIntakeStowed());
+            break;
+        case Action::kToggleContainerGrab:
+            elevator.ContainerGrab(!elevator.IsContainerGrabbed());
+            break;
+        case Action::kToggleManualMode:
+            elevator.SetManualMode(!elevator.IsManualMode());
+            break;
+        case Action::kStackTotes:
+            elevator.StackTotes();
+            break;
+        case Action::kSetHeight:
+            elevator.RaiseElevator(units::inch_t{binding.height});
+            break;
+    }
+}
+
+ButtonBindings Robot::LoadBindings() {
+    wpi::SmallString<128> path;
+    frc::filesystem::GetDeployDirectory(path);
+    wpi::sys::path::append(path, "bindings.json");
+
+    // A bad file falls back to the built-in bindings rather than keeping the
+    // robot from starting. The error goes to the Driver Station so the drive
+    // team sees it before a match.
+    try {
+        return ButtonBindings::Load(path);
+    } catch (const std::invalid_argument& e) {
+        frc::DriverStation::ReportError(
+            fmt::format("Failed to load button bindings, so the defaults are "
+                        "used: {}",
+                        e.what()));
+        return ButtonBindings{kDefaultBindings};
+    }
+}
+
+std::vector<AutoScript> Robot::LoadAutoScripts() {
+    wpi::SmallString<128> path;
+    frc::filesystem::GetDeployDirectory(path);
+    wpi::sys::path::append(path, "autonomous");
+    return AutoScript::LoadDirectory(path);
+}
+
+std::vector<frc3512::AutonomousMode> Robot::MakeAutonomousModes() {
+    std::vector<frc3512::AutonomousMode> modes{
+        {"DriveForward", [=] { AutoDriveForward(); }},
+        {"ResetElevator", [=] { AutoResetElevator(); }},
+        {"OneCanLeft", [=] { AutoOneCanLeft(); }},
+        {"OneCanCenter", [=] { AutoOneCanCenter(); }},
+        {"OneCanRight", [=] { AutoOneCanRight(); }},
+        {"OneTote", [=] { AutoOneTote(); }}};
+
+    for (const auto& script : autoScripts) {
+        auto sameName = [&](const auto& mode) {
+            return mode.name == script.GetName();
+        };
+        if (script.GetName() == kDefaultModeName ||
+            std::any_of(modes.begin(), modes.end(), sameName)) {
+            fmt::print("Skipped autonomous script {}: name is already used\n",
+                       script.GetName());
+            continue;
+        }
+
+        modes.push_back(
+            {script.GetName(), [=, &script] { AutoRunScript(script); }});
+    }
+
+    return modes;
 }
 
 #ifndef RUNNING_FRC_TESTS
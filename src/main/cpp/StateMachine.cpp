@@ -1,50 +1,83 @@
-// Copyright (c) 2015-2020 FRC Team 3512. All Rights Reserved.
+// Copyright (c) 2015-2021 FRC Team 3512. All Rights Reserved.
 
 #include "StateMachine.hpp"
 
-#include <iostream>
+#include <optional>
 #include <string>
 #include <utility>
 
+#include <fmt/core.h>
+
 StateMachine::StateMachine(std::string name) : State(std::move(name)) {
-    run = [this] {
-        if (m_currentState == nullptr) {
-            return;
-        }
+    run = [this] { m_machine.Run(); };
+}
+
+void StateMachine::AddState(State&& state) {
+    size_t index = m_states.size();
+    m_machine.AddState(index, Adapt(std::move(state)));
+}
+
+void StateMachine::AddState(State&& state, const std::string& parent) {
+    auto it = m_indices.find(parent);
+    if (it == m_indices.end()) {
+        fmt::print("[{}] is not a known state\n", parent);
+        return;
+    }
+    size_t parentIndex = it->second;
+
+    size_t index = m_states.size();
+    m_machine.AddState(index, Adapt(std::move(state)), parentIndex);
+}
+
+TypedState<size_t> StateMachine::Adapt(State&& state) {
+    size_t index = m_states.size();
+    m_states.push_back(std::move(state));
+    m_indices.insert(std::make_pair(m_states.back().Name(), index));
 
-        m_currentState->run();
+    const State* adaptee = &m_states.back();
+    TypedState<size_t> typedState;
+    typedState.entry = [adaptee] { adaptee->entry(); };
+    typedState.run = [adaptee] { adaptee->run(); };
+    typedState.exit = [adaptee] { adaptee->exit(); };
+    typedState.transition = [this, adaptee]() -> std::optional<size_t> {
+        std::string nextState = adaptee->transition();
 
-        std::string nextState = m_currentState->transition();
+        if (nextState.size() == 0) {
+            return std::nullopt;
+        }
 
-        if (nextState.size() != 0) {
-            if (!SetState(nextState)) {
-                // Failed to find state matching the returned name
-                std::cout << "[" << nextState << "] is not a known state\n";
-            }
+        auto it = m_indices.find(nextState);
+        if (it == m_indices.end()) {
+            // Failed to find state matching the returned name
+            fmt::print("[{}] is not a known state\n", nextState);
+            return std::nullopt;
         }
+        return it->second;
     };
+    return typedState;
 }
 
 bool StateMachine::SetState(const std::string& newState) {
-    for (const auto& state : m_states) {
-        if (state.Name() == newState) {
-            if (m_currentState != nullptr) {
-                m_currentState->exit();
-            }
-            m_currentState = &state;
-            m_currentState->entry();
-
-            return true;
-        }
+    auto it = m_indices.find(newState);
+    if (it == m_indices.end()) {
+        return false;
     }
 
-    return false;
+    return m_machine.SetState(it->second);
 }
 
 const std::string StateMachine::GetState() const {
-    if (m_currentState != nullptr) {
-        return m_currentState->Name();
+    if (auto index = m_machine.GetState()) {
+        return m_states[*index].Name();
     } else {
         return "";
     }
 }
+
+StateMachine::Snapshot StateMachine::Save() const { return m_machine.Save(); }
+
+bool StateMachine::Restore(const Snapshot& snapshot) {
+    return m_machine.Restore(snapshot);
+}
+
+TransitionTrace& StateMachine::GetTrace() { return m_machine.GetTrace(); }
@@ -0,0 +1,108 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "StatusFrameBudget.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <fmt/core.h>
+#include <units/frequency.h>
+
+StatusFrameBudget::StatusFrameBudget(double maxBusLoad)
+    : m_maxBusLoad{maxBusLoad} {}
+
+void StatusFrameBudget::Add(ctre::phoenix::motorcontrol::can::TalonSRX& talon,
+                            std::initializer_list<Need> needs) {
+    auto device = std::find_if(
+        m_devices.begin(), m_devices.end(),
+        [&](const auto& entry) { return entry.talon == &talon; });
+    if (device == m_devices.end()) {
+        Periods periods;
+        periods.fill(kSlowestPeriod);
+        device = m_devices.insert(m_devices.end(), Device{&talon, periods});
+    }
+
+    for (const auto& need : needs) {
+        if (need.period < 1_ms || need.period > kSlowestPeriod) {
+            throw std::invalid_argument{fmt::format(
+                "Status frame period of {} ms on Talon {} is out of range",
+                need.period.to<double>(), talon.GetDeviceID())};
+        }
+
+        auto frame = std::find_if(
+            kFrames.begin(), kFrames.end(),
+            [&](const auto& managed) { return managed.frame == need.frame; });
+        if (frame == kFrames.end()) {
+            throw std::invalid_argument{fmt::format(
+                "Status frame {:#x} on Talon {} isn't managed",
+                static_cast<int>(need.frame), talon.GetDeviceID())};
+        }
+
+        auto& period = device->periods[frame - kFrames.begin()];
+        period = std::min(period, need.period);
+    }
+}
+
+double StatusFrameBudget::GetBusLoad() const {
+    double load = 0.0;
+    for (const auto& device : m_devices) {
+        load += DeviceBusLoad(device.periods);
+    }
+    return load;
+}
+
+double StatusFrameBudget::GetDefaultBusLoad() const {
+    Periods periods;
+    for (size_t i = 0; i < kFrames.size(); ++i) {
+        periods[i] = kFrames[i].defaultPeriod;
+    }
+    return m_devices.size() * DeviceBusLoad(periods);
+}
+
+void StatusFrameBudget::Apply() {
+    for (const auto& device : m_devices) {
+        ApplyPeriods(device);
+    }
+
+    double load = GetBusLoad();
+    fmt::print("{} Talons use {:.1f}% of the CAN bus ({:.1f}% by default)\n",
+               m_devices.size(), load * 100.0, GetDefaultBusLoad() * 100.0);
+    if (load > m_maxBusLoad) {
+        fmt::print("Warning: Talons are over the {:.1f}% CAN bus budget\n",
+                   m_maxBusLoad * 100.0);
+    }
+}
+
+size_t StatusFrameBudget::ReapplyIfReset() {
+    size_t resets = 0;
+    for (const auto& device : m_devices) {
+        // Reading the flag clears it
+        if (device.talon->HasResetOccurred()) {
+            ApplyPeriods(device);
+            fmt::print("Talon {} reset, so its status frame periods were set "
+                       "again\n",
+                       device.talon->GetDeviceID());
+            ++resets;
+        }
+    }
+    return resets;
+}
+
+double StatusFrameBudget::DeviceBusLoad(const Periods& periods) {
+    units::hertz_t frameRate = 1 / kControlFramePeriod;
+    for (const auto& period : periods) {
+        frameRate += units::hertz_t{1 / period};
+    }
+    return frameRate.to<double>() * kBitsPerFrame / kBitRate;
+}
+
+void StatusFrameBudget::ApplyPeriods(const Device& device) {
+    for (size_t i = 0; i < kFrames.size(); ++i) {
+        device.talon->SetStatusFramePeriod(
+            kFrames[i].frame,
+            static_cast<uint8_t>(device.periods[i].to<double>()), 0);
+    }
+}
@@ -3,9 +3,7 @@
 #include "TalonSRXGroup.hpp"
 
 void TalonSRXGroup::Set(double speed) {
-    using namespace ctre::phoenix::motorcontrol;
-    m_leader->Set(TalonSRXControlMode::PercentOutput,
-                  m_isInverted ? -speed : speed);
+    m_output = m_isInverted ? -speed : speed;
     m_speed = speed;
 }
 
@@ -16,15 +14,30 @@ void TalonSRXGroup::SetInverted(bool isInverted) { m_isInverted = isInverted; }
 bool TalonSRXGroup::GetInverted() const { return m_isInverted; }
 
 void TalonSRXGroup::Disable() {
-    using namespace ctre::phoenix::motorcontrol;
-    m_leader->Set(TalonSRXControlMode::PercentOutput, 0.0);
+    m_output = 0.0;
     m_speed = 0.0;
+    SendOutput(0.0);
 }
 
 void TalonSRXGroup::StopMotor() {
-    using namespace ctre::phoenix::motorcontrol;
-    m_leader->Set(TalonSRXControlMode::PercentOutput, 0.0);
+    m_output = 0.0;
     m_speed = 0.0;
+    SendOutput(0.0);
 }
 
 void TalonSRXGroup::PIDWrite(double output) { Set(output); }
+
+void TalonSRXGroup::Flush() {
+    if (m_output != m_sentOutput) {
+        SendOutput(m_output);
+    }
+}
+
+void TalonSRXGroup::SendOutput(double output) {
+    using namespace ctre::phoenix::motorcontrol;
+    m_leader->Set(TalonSRXControlMode::PercentOutput, output);
+    m_sentOutput = output;
+    if (m_simOutput) {
+        m_simOutput.Set(output);
+    }
+}
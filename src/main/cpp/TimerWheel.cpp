@@ -0,0 +1,93 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "TimerWheel.hpp"
+
+TimerWheel::TimerWheel(size_t capacity) {
+    m_slots.fill(kNone);
+    Reserve(capacity);
+}
+
+void TimerWheel::Reserve(size_t capacity) {
+    if (capacity > m_nodes.size()) {
+        m_nodes.resize(capacity);
+    }
+}
+
+void TimerWheel::Schedule(size_t id, uint64_t delay) {
+    Cancel(id);
+
+    if (delay == 0) {
+        delay = 1;
+    } else if (delay > kMaxDelay) {
+        delay = kMaxDelay;
+    }
+    m_nodes[id].expiry = m_tick + delay;
+    Insert(static_cast<int32_t>(id));
+}
+
+void TimerWheel::Cancel(size_t id) {
+    if (IsScheduled(id)) {
+        Unlink(static_cast<int32_t>(id));
+    }
+}
+
+bool TimerWheel::IsScheduled(size_t id) const {
+    return m_nodes[id].slot != kNone;
+}
+
+uint64_t TimerWheel::GetRemaining(size_t id) const {
+    if (!IsScheduled(id)) {
+        return 0;
+    }
+    return m_nodes[id].expiry - m_tick;
+}
+
+void TimerWheel::Insert(int32_t id) {
+    auto& node = m_nodes[id];
+    uint64_t delta = node.expiry - m_tick;
+
+    int level = 0;
+    while (level < kLevels - 1 &&
+           delta >= (uint64_t{1} << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+
+    int32_t slot =
+        level * kSlots + ((node.expiry >> (kSlotBits * level)) & (kSlots - 1));
+    node.prev = kNone;
+    node.next = m_slots[slot];
+    if (node.next != kNone) {
+        m_nodes[node.next].prev = id;
+    }
+    m_slots[slot] = id;
+    node.slot = slot;
+}
+
+void TimerWheel::Unlink(int32_t id) {
+    auto& node = m_nodes[id];
+    if (node.prev != kNone) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        m_slots[node.slot] = node.next;
+    }
+    if (node.next != kNone) {
+        m_nodes[node.next].prev = node.prev;
+    }
+    node.prev = kNone;
+    node.next = kNone;
+    node.slot = kNone;
+}
+
+void TimerWheel::Cascade(int level) {
+    auto& head = m_slots[level * kSlots +
+                         ((m_tick >> (kSlotBits * level)) & (kSlots - 1))];
+    int32_t id = head;
+    head = kNone;
+
+    while (id != kNone) {
+        int32_t next = m_nodes[id].next;
+        m_nodes[id].slot = kNone;
+        Insert(id);
+        id = next;
+    }
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "TransitionTraceLogger.hpp"
+
+#include <chrono>
+
+#include <fmt/core.h>
+#include <frc/Filesystem.h>
+#include <networktables/NetworkTableInstance.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/Path.h>
+#include <wpi/SmallString.h>
+
+static_assert(sizeof(TransitionTraceLogger::FileRecord) == 24,
+              "FileRecord has padding");
+
+TransitionTraceLogger::TransitionTraceLogger(wpi::StringRef filename,
+                                             units::second_t period)
+    : m_period{period} {
+    wpi::SmallString<128> path;
+    frc::filesystem::GetOperatingDirectory(path);
+    wpi::sys::path::append(path, filename);
+    m_path = path.str();
+}
+
+TransitionTraceLogger::~TransitionTraceLogger() { Stop(); }
+
+void TransitionTraceLogger::AddTrace(wpi::StringRef name,
+                                     TransitionTrace& trace) {
+    auto table =
+        nt::NetworkTableInstance::GetDefault().GetTable("Transitions");
+
+    std::scoped_lock lock{m_mutex};
+    m_sources.emplace_back(Source{name, &trace, table->GetEntry(name)});
+}
+
+void TransitionTraceLogger::Start() {
+    std::scoped_lock lock{m_mutex};
+    if (m_running) {
+        return;
+    }
+
+    m_file = fopen(m_path.c_str(), "wb");
+    if (m_file == nullptr) {
+        fmt::print("Failed to open {}\n", m_path);
+    } else {
+        WriteHeader();
+    }
+
+    m_running = true;
+    m_thread = std::thread{[=] {
+        std::unique_lock lock{m_mutex};
+        auto period = std::chrono::duration<double>{m_period.to<double>()};
+        while (m_running) {
+            m_cond.wait_for(lock, period, [&] { return !m_running; });
+            DrainAll();
+        }
+    }};
+}
+
+void TransitionTraceLogger::Stop() {
+    {
+        std::scoped_lock lock{m_mutex};
+        m_running = false;
+    }
+    m_cond.notify_one();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    if (m_file != nullptr) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+void TransitionTraceLogger::WriteHeader() {
+    fwrite("SMTRACE1", 1, 8, m_file);
+
+    uint32_t count = static_cast<uint32_t>(m_sources.size());
+    fwrite(&count, sizeof(count), 1, m_file);
+
+    for (const auto& source : m_sources) {
+        uint32_t length = static_cast<uint32_t>(source.name.size());
+        fwrite(&length, sizeof(length), 1, m_file);
+        fwrite(source.name.data(), 1, length, m_file);
+    }
+}
+
+void TransitionTraceLogger::DrainAll() {
+    for (size_t i = 0; i < m_sources.size(); ++i) {
+        auto& source = m_sources[i];
+
+        TransitionRecord last;
+        size_t count = source.trace->Drain([&](const TransitionRecord& record) {
+            last = record;
+
+            if (m_file != nullptr) {
+                FileRecord fileRecord{
+                    record.timestamp, record.tick, record.from, record.to,
+                    static_cast<uint32_t>(i),
+                    static_cast<uint32_t>(source.trace->GetDropped())};
+                fwrite(&fileRecord, sizeof(fileRecord), 1, m_file);
+            }
+        });
+
+        if (count > 0) {
+            double values[] = {static_cast<double>(last.timestamp),
+                               static_cast<double>(last.from),
+                               static_cast<double>(last.to),
+                               static_cast<double>(last.tick)};
+            source.entry.SetDoubleArray(values);
+        }
+    }
+
+    if (m_file != nullptr) {
+        fflush(m_file);
+    }
+}
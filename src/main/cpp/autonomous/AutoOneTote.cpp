@@ -6,62 +6,31 @@ void Robot::AutoOneTote() {
     elevator.SetManualMode(false);
     elevator.SetIntakeDirection(Elevator::S_STOPPED);
 
-    // Seek garbage can up
-    elevator.RaiseElevator(Elevator::kGarbageCanHeight);
-    elevator.StowIntake(false);
-    while (!elevator.AtGoal()) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
-
-    // Move to tote
-    frc2::Timer timer;
-    timer.Start();
-    while (!timer.HasPeriodPassed(1_s)) {
-        drivetrain.Drive(-0.3, 0, false);
-
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+    autonChooser.Parallel(
+        {// Seek garbage can up
+         [=] {
+             elevator.RaiseElevator(Elevator::kGarbageCanHeight);
+             elevator.StowIntake(false);
+             autonChooser.WaitUntil([=] { return elevator.AtGoal(); });
+         },
+         // Move to tote
+         [=] {
+             autonChooser.WaitFor(1_s,
+                                  [=] { drivetrain.Drive(-0.3, 0, false); });
+         }});
 
     // Autostack
-    timer.Reset();
     elevator.IntakeGrab(true);
     elevator.SetIntakeDirection(Elevator::S_REVERSE);
-    while (!timer.HasPeriodPassed(1_s)) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+    autonChooser.WaitFor(1_s);
 
     // Turn
-    timer.Reset();
     elevator.SetIntakeDirection(Elevator::S_REVERSE);
-    while (!timer.HasPeriodPassed(1_s)) {
-        drivetrain.Drive(-0.3, -0.3, true);
-
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+    autonChooser.WaitFor(1_s, [=] { drivetrain.Drive(-0.3, -0.3, true); });
     drivetrain.Drive(0.0, 0.0, false);
 
     // Run away
-    timer.Reset();
     elevator.SetIntakeDirection(Elevator::S_REVERSE);
-    while (!timer.HasPeriodPassed(3_s)) {
-        drivetrain.Drive(-0.3, 0, false);
-
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+    autonChooser.WaitFor(3_s, [=] { drivetrain.Drive(-0.3, 0, false); });
     drivetrain.Drive(0, 0, false);
 }
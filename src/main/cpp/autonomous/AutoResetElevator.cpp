@@ -9,10 +9,5 @@ void Robot::AutoResetElevator() {
 
     // Seek ground
     elevator.RaiseElevator(Elevator::kGroundHeight);
-    while (!elevator.AtGoal()) {
-        autonChooser.YieldToMain();
-        if (!IsAutonomousEnabled()) {
-            return;
-        }
-    }
+    autonChooser.WaitUntil([=] { return elevator.AtGoal(); });
 }
@@ -0,0 +1,45 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include "Robot.hpp"
+
+void Robot::AutoRunScript(const AutoScript& script) {
+    using Opcode = AutoScript::Opcode;
+
+    elevator.SetManualMode(false);
+
+    for (const auto& instruction : script.GetInstructions()) {
+        const auto& args = instruction.args;
+
+        switch (instruction.opcode) {
+            case Opcode::kDrive:
+                autonChooser.WaitFor(units::second_t{args[0]}, [&] {
+                    drivetrain.Drive(args[1], args[2], instruction.operand);
+                });
+                drivetrain.Drive(0.0, 0.0, false);
+                break;
+            case Opcode::kSetHeight:
+                elevator.RaiseElevator(units::inch_t{args[0]});
+                break;
+            case Opcode::kElevatorGrab:
+                elevator.ElevatorGrab(instruction.operand);
+                break;
+            case Opcode::kIntakeGrab:
+                elevator.IntakeGrab(instruction.operand);
+                break;
+            case Opcode::kStowIntake:
+                elevator.StowIntake(instruction.operand);
+                break;
+            case Opcode::kSetIntakeDirection:
+                elevator.SetIntakeDirection(
+                    static_cast<Elevator::IntakeMotorState>(
+                        instruction.operand));
+                break;
+            case Opcode::kWait:
+                autonChooser.WaitFor(units::second_t{args[0]});
+                break;
+            case Opcode::kWaitForGoal:
+                autonChooser.WaitUntil([=] { return elevator.AtGoal(); });
+                break;
+        }
+    }
+}
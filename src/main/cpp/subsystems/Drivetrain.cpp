@@ -5,13 +5,46 @@
 #include <cmath>
 
 #include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+#include <frc/smartdashboard/SmartDashboard.h>
+#include <frc2/Timer.h>
 
-Drivetrain::Drivetrain() { m_leftGrbx.SetInverted(true); }
+Drivetrain::Drivetrain() {
+    m_leftGrbx.SetInverted(true);
+
+    frc::SmartDashboard::PutData("Left drive encoder", &m_leftEncoder);
+    frc::SmartDashboard::PutData("Right drive encoder", &m_rightEncoder);
+}
 
 void Drivetrain::Drive(double throttle, double turn, bool isQuickTurn) {
     m_drive.CurvatureDrive(throttle, turn, isQuickTurn);
 }
 
+void Drivetrain::AddStatusFrames(StatusFrameBudget& budget) {
+    using Frame = StatusFrameBudget::Frame;
+
+    // The encoders are sampled every 20 ms tick, so sending them twice as
+    // often keeps each sample under 10 ms old. The followers take their
+    // output from the leader's general frame, so it keeps its default period.
+    budget.Add(m_frontLeftMotor,
+               {{Frame::Status_1_General, 10_ms},
+                {Frame::Status_3_Quadrature, CANEncoder::kStatusFramePeriod}});
+    budget.Add(m_frontRightMotor,
+               {{Frame::Status_1_General, 10_ms},
+                {Frame::Status_3_Quadrature, CANEncoder::kStatusFramePeriod}});
+    budget.Add(m_backLeftMotor);
+    budget.Add(m_backRightMotor);
+}
+
+void Drivetrain::SampleSensors() {
+    m_leftEncoder.Sample();
+    m_rightEncoder.Sample();
+}
+
+void Drivetrain::FlushOutputs() {
+    m_leftGrbx.Flush();
+    m_rightGrbx.Flush();
+}
+
 void Drivetrain::ResetEncoders() {
     m_leftEncoder.Reset();
     m_rightEncoder.Reset();
@@ -51,8 +84,11 @@ void Drivetrain::SetSetpointsToMeasurements() {
 }
 
 void Drivetrain::UpdateControllers() {
-    m_leftGrbx.Set(
-        m_leftController.Calculate(units::inch_t{m_leftEncoder.GetDistance()}));
+    // The encoder readings are a few milliseconds old, so they're extrapolated
+    // to now
+    auto now = frc2::Timer::GetFPGATimestamp();
+    m_leftGrbx.Set(m_leftController.Calculate(
+        units::inch_t{m_leftEncoder.GetSample().PredictDistance(now)}));
     m_rightGrbx.Set(m_rightController.Calculate(
-        units::inch_t{m_rightEncoder.GetDistance()}));
+        units::inch_t{m_rightEncoder.GetSample().PredictDistance(now)}));
 }
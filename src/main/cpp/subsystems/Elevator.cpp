@@ -2,113 +2,139 @@
 
 #include "subsystems/Elevator.hpp"
 
+#include <optional>
 #include <utility>
 
+#include <frc/smartdashboard/SmartDashboard.h>
+#include <frc2/Timer.h>
 #include <wpi/raw_ostream.h>
 
+namespace {
+
+struct HeightPreset {
+    const char* name;
+    units::inch_t height;
+};
+
+constexpr HeightPreset kHeightPresets[] = {
+    {"ground", Elevator::kGroundHeight},
+    {"tote1", Elevator::kToteHeight1},
+    {"tote2", Elevator::kToteHeight2},
+    {"tote3", Elevator::kToteHeight3},
+    {"tote4", Elevator::kToteHeight4},
+    {"tote5", Elevator::kToteHeight5},
+    {"step", Elevator::kStepHeight},
+    {"garbagecan", Elevator::kGarbageCanHeight},
+    {"autodrop", Elevator::kAutoDropHeight},
+    {"max", Elevator::kMaxHeight}};
+
+struct IntakeDirection {
+    const char* name;
+    Elevator::IntakeMotorState state;
+};
+
+constexpr IntakeDirection kIntakeDirections[] = {
+    {"stop", Elevator::S_STOPPED},
+    {"forward", Elevator::S_FORWARD},
+    {"reverse", Elevator::S_REVERSE},
+    {"ccw", Elevator::S_ROTATE_CCW},
+    {"cw", Elevator::S_ROTATE_CW}};
+
+}  // namespace
+
 Elevator::Elevator() {
-    State state{"IDLE"};
+    TypedState<AutoStackState> state;
     state.entry = [this] { m_startAutoStacking = false; };
-    state.transition = [this] {
+    state.transition = [this]() -> std::optional<AutoStackState> {
         if (m_startAutoStacking) {
-            return "WAIT_INITIAL_HEIGHT";
+            return S_STACKING;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
-    m_autoStackSM.SetState("IDLE");
+    state.events = E_STACK_REQUESTED;
+    m_autoStackSM.AddState(S_IDLE, std::move(state));
+
+    // Entering S_STACKING enters its first substate, S_WAIT_INITIAL_HEIGHT
+    state = TypedState<AutoStackState>{};
+    state.events = 0;
+    m_autoStackSM.AddState(S_STACKING, std::move(state));
 
-    state = State{"WAIT_INITIAL_HEIGHT"};
+    state = TypedState<AutoStackState>{};
     state.entry = [this] { SetGoal(kToteHeight1); };
-    state.transition = [this] {
+    state.transition = [this]() -> std::optional<AutoStackState> {
         if (AtGoal()) {
-            return "SEEK_DROP_TOTES";
+            return S_SEEK_DROP_TOTES;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    state.events = E_GOAL_REACHED;
+    m_autoStackSM.AddState(S_WAIT_INITIAL_HEIGHT, std::move(state),
+                           S_STACKING);
 
-    state = State{"SEEK_DROP_TOTES"};
+    state = TypedState<AutoStackState>{};
     state.entry = [this] {
         SetGoal(m_controller.GetGoal().position - kAutoDropHeight);
     };
-    state.transition = [this] {
+    state.transition = [this]() -> std::optional<AutoStackState> {
         if (AtGoal()) {
-            return "RELEASE";
+            return S_RELEASE;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    state.events = E_GOAL_REACHED;
+    m_autoStackSM.AddState(S_SEEK_DROP_TOTES, std::move(state), S_STACKING);
 
-    state = State{"RELEASE"};
-    state.entry = [this] {
-        m_grabTimer.Reset();
-        m_grabTimer.Start();
-        ElevatorGrab(false);
-    };
-    state.transition = [this] {
-        if (m_grabTimer.HasPeriodPassed(0.2_s)) {
-            return "SEEK_GROUND";
-        } else {
-            return "";
-        }
-    };
-    m_autoStackSM.AddState(std::move(state));
+    state = TypedState<AutoStackState>{};
+    state.entry = [this] { ElevatorGrab(false); };
+    state.events = 0;
+    state.timeout = 0.2_s;
+    state.timeoutState = S_SEEK_GROUND;
+    m_autoStackSM.AddState(S_RELEASE, std::move(state), S_STACKING);
 
-    state = State{"SEEK_GROUND"};
+    state = TypedState<AutoStackState>{};
     state.entry = [this] { SetGoal(kGroundHeight); };
-    state.transition = [this] {
+    state.transition = [this]() -> std::optional<AutoStackState> {
         if (AtGoal()) {
-            return "GRAB";
+            return S_GRAB;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    state.events = E_GOAL_REACHED;
+    m_autoStackSM.AddState(S_SEEK_GROUND, std::move(state), S_STACKING);
 
-    state = State{"GRAB"};
-    state.entry = [this] {
-        m_grabTimer.Reset();
-        m_grabTimer.Start();
-        ElevatorGrab(true);
-    };
-    state.transition = [this] {
-        if (m_grabTimer.HasPeriodPassed(0.4_s)) {
-            return "SEEK_HALF_TOTE";
-        } else {
-            return "";
-        }
-    };
-    m_autoStackSM.AddState(std::move(state));
+    state = TypedState<AutoStackState>{};
+    state.entry = [this] { ElevatorGrab(true); };
+    state.events = 0;
+    state.timeout = 0.4_s;
+    state.timeoutState = S_SEEK_HALF_TOTE;
+    m_autoStackSM.AddState(S_GRAB, std::move(state), S_STACKING);
 
-    state = State{"SEEK_HALF_TOTE"};
+    state = TypedState<AutoStackState>{};
     state.entry = [this] { SetGoal(kToteHeight2); };
-    state.transition = [this] {
+    state.transition = [this]() -> std::optional<AutoStackState> {
         if (AtGoal()) {
-            return "INTAKE_IN";
+            return S_INTAKE_IN;
         } else {
-            return "";
+            return std::nullopt;
         }
     };
-    m_autoStackSM.AddState(std::move(state));
+    state.events = E_GOAL_REACHED;
+    m_autoStackSM.AddState(S_SEEK_HALF_TOTE, std::move(state), S_STACKING);
 
-    state = State{"INTAKE_IN"};
-    state.entry = [this] {
-        m_grabTimer.Reset();
-        m_grabTimer.Start();
-        IntakeGrab(true);
-    };
-    state.transition = [this] {
-        if (m_grabTimer.HasPeriodPassed(0.2_s)) {
-            return "IDLE";
-        } else {
-            return "";
-        }
-    };
-    m_autoStackSM.AddState(std::move(state));
+    state = TypedState<AutoStackState>{};
+    state.entry = [this] { IntakeGrab(true); };
+    state.events = 0;
+    state.timeout = 0.2_s;
+    state.timeoutState = S_IDLE;
+    m_autoStackSM.AddState(S_INTAKE_IN, std::move(state), S_STACKING);
+
+    m_autoStackSM.SetState(S_IDLE);
+
+    frc::SmartDashboard::PutData("Lift encoder", &m_liftEncoder);
 }
 
 void Elevator::ElevatorGrab(bool state) { m_elevatorGrabber.Set(!state); }
@@ -131,20 +157,20 @@ void Elevator::SetIntakeDirection(IntakeMotorState state) {
     m_intakeState = state;
 
     if (state == S_STOPPED) {
-        m_intakeLeftMotor.Set(0);
-        m_intakeRightMotor.Set(0);
+        m_intakeLeft.Set(0);
+        m_intakeRight.Set(0);
     } else if (state == S_FORWARD) {
-        m_intakeLeftMotor.Set(1);
-        m_intakeRightMotor.Set(-1);
+        m_intakeLeft.Set(1);
+        m_intakeRight.Set(-1);
     } else if (state == S_REVERSE) {
-        m_intakeLeftMotor.Set(-1);
-        m_intakeRightMotor.Set(1);
+        m_intakeLeft.Set(-1);
+        m_intakeRight.Set(1);
     } else if (state == S_ROTATE_CCW) {
-        m_intakeLeftMotor.Set(-1);
-        m_intakeRightMotor.Set(-1);
+        m_intakeLeft.Set(-1);
+        m_intakeRight.Set(-1);
     } else if (state == S_ROTATE_CW) {
-        m_intakeLeftMotor.Set(1);
-        m_intakeRightMotor.Set(1);
+        m_intakeLeft.Set(1);
+        m_intakeRight.Set(1);
     }
 }
 
@@ -171,7 +197,7 @@ void Elevator::SetManualMode(bool on) {
 
         if (m_manual) {
             // Stop any auto-stacking when we switch to manual mode
-            m_autoStackSM.SetState("IDLE");
+            m_autoStackSM.SetState(S_IDLE);
         } else {
             SetGoal(GetHeight());
         }
@@ -186,12 +212,62 @@ void Elevator::SetHeight(units::meter_t height) {
     }
 }
 
+std::optional<units::inch_t> Elevator::FindHeightPreset(wpi::StringRef name) {
+    for (const auto& preset : kHeightPresets) {
+        if (name == preset.name) {
+            return preset.height;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Elevator::IntakeMotorState> Elevator::FindIntakeDirection(
+    wpi::StringRef name) {
+    for (const auto& direction : kIntakeDirections) {
+        if (name == direction.name) {
+            return direction.state;
+        }
+    }
+    return std::nullopt;
+}
+
 units::meter_t Elevator::GetHeight() {
-    return units::inch_t{m_liftEncoder.GetDistance()};
+    // The encoder reading is a few milliseconds old, so it's extrapolated to
+    // now
+    return units::inch_t{m_liftEncoder.GetSample().PredictDistance(
+        frc2::Timer::GetFPGATimestamp())};
 }
 
 void Elevator::ResetEncoders() { m_liftEncoder.Reset(); }
 
+void Elevator::AddStatusFrames(StatusFrameBudget& budget) {
+    using Frame = StatusFrameBudget::Frame;
+
+    // The limit switch is in the general frame, which the follower also takes
+    // its output from
+    budget.Add(m_liftLeftMotor,
+               {{Frame::Status_1_General, 10_ms},
+                {Frame::Status_3_Quadrature, CANEncoder::kStatusFramePeriod}});
+    budget.Add(m_liftRightMotor);
+    budget.Add(m_intakeLeftMotor);
+    budget.Add(m_intakeRightMotor);
+}
+
+void Elevator::SampleSensors() {
+    m_liftEncoder.Sample();
+    m_limitSwitch.Sample();
+}
+
+void Elevator::FlushOutputs() {
+    m_liftGrbx.Flush();
+    m_intakeLeft.Flush();
+    m_intakeRight.Flush();
+    m_elevatorGrabber.Flush();
+    m_containerGrabber.Flush();
+    m_intakeStower.Flush();
+    m_intakeGrabber.Flush();
+}
+
 void Elevator::RaiseElevator(units::meter_t level) {
     /* Only allow changing the elevator height manually if not currently
      * auto-stacking
@@ -205,14 +281,52 @@ void Elevator::RaiseElevator(units::meter_t level) {
 void Elevator::StackTotes() {
     SetManualMode(false);
     m_startAutoStacking = true;
+    m_autoStackSM.PostEvent(E_STACK_REQUESTED);
+}
+
+bool Elevator::IsStacking() const {
+    return m_autoStackSM.IsInState(S_STACKING);
 }
 
-bool Elevator::IsStacking() const { return m_autoStackSM.GetState() != "IDLE"; }
+void Elevator::CancelStack() { m_autoStackSM.SetState(S_IDLE); }
+
+Elevator::AutoStackSnapshot Elevator::SaveAutoStack() const {
+    AutoStackSnapshot snapshot;
+    snapshot.machine = m_autoStackSM.Save();
+    snapshot.goal = m_controller.GetGoal();
+    snapshot.setpoint = m_controller.GetSetpoint();
+    snapshot.startAutoStacking = m_startAutoStacking;
+    snapshot.lastAtGoal = m_lastAtGoal;
+    snapshot.elevatorGrabbed = IsElevatorGrabbed();
+    snapshot.intakeGrabbed = IsIntakeGrabbed();
+    return snapshot;
+}
 
-void Elevator::CancelStack() { m_autoStackSM.SetState("IDLE"); }
+void Elevator::RestoreAutoStack(const AutoStackSnapshot& snapshot) {
+    // Select the same constraints SetGoal() would have
+    if (snapshot.goal.position > snapshot.setpoint.position) {
+        m_controller.SetConstraints({kMaxVUp, kMaxAUp});
+    } else if (snapshot.goal.position > 0_in) {
+        m_controller.SetConstraints({kMaxVDown, kMaxADown});
+    } else {
+        m_controller.SetConstraints({kMaxVDownZeroing, kMaxADown});
+    }
+    m_controller.Reset(snapshot.setpoint);
+    m_controller.SetGoal(snapshot.goal);
+
+    m_autoStackSM.Restore(snapshot.machine);
+    m_startAutoStacking = snapshot.startAutoStacking;
+    m_lastAtGoal = snapshot.lastAtGoal;
+    ElevatorGrab(snapshot.elevatorGrabbed);
+    IntakeGrab(snapshot.intakeGrabbed);
+}
+
+TransitionTrace& Elevator::GetAutoStackTrace() {
+    return m_autoStackSM.GetTrace();
+}
 
 void Elevator::UpdateState() {
-    m_autoStackSM.run();
+    m_autoStackSM.Run();
 
     /* Opens intake if the elevator is at the same level as it or if the tines
      * are open
@@ -225,14 +339,21 @@ void Elevator::UpdateState() {
     }
 
     // If elevator is at ground and wasn't before
-    if (!m_lastLimitSwitchValue && m_limitSwitch.Get()) {
+    bool limitSwitchValue = m_limitSwitch.Get();
+    if (!m_lastLimitSwitchValue && limitSwitchValue) {
         m_liftEncoder.Reset();
         SetGoal(GetHeight());
     }
-    m_liftGrbx.Set(
-        m_controller.Calculate(units::inch_t{m_liftEncoder.GetDistance()}));
 
-    m_lastLimitSwitchValue = m_limitSwitch.Get();
+    m_liftGrbx.Set(m_controller.Calculate(GetHeight()));
+
+    m_lastLimitSwitchValue = limitSwitchValue;
+
+    bool atGoal = AtGoal();
+    if (atGoal && !m_lastAtGoal) {
+        m_autoStackSM.PostEvent(E_GOAL_REACHED);
+    }
+    m_lastAtGoal = atGoal;
 }
 
 bool Elevator::AtGoal() const { return m_controller.AtGoal(); }
@@ -0,0 +1,94 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <wpi/StringRef.h>
+
+/**
+ * An autonomous mode compiled from a script.
+ *
+ * Scripts are text files with one command per line. Everything after a '#' is
+ * a comment. The commands are:
+ *
+ * - drive <seconds> <throttle> <turn> [quickturn]: drives, then stops
+ * - height <preset>: moves the elevator to ground, tote1 through tote5, step,
+ *   garbagecan, autodrop, or max
+ * - grab elevator|intake, release elevator|intake: actuates the elevator tines
+ *   or intake arms
+ * - stow intake, unstow intake
+ * - intake stop|forward|reverse|ccw|cw: sets the intake wheels' direction
+ * - wait <seconds>
+ * - wait goal: waits until the elevator is at its goal
+ *
+ * A script is compiled once into a flat array of fixed-size instructions, so
+ * running it doesn't parse or allocate.
+ */
+class AutoScript {
+public:
+    enum class Opcode : uint8_t {
+        kDrive,
+        kSetHeight,
+        kElevatorGrab,
+        kIntakeGrab,
+        kStowIntake,
+        kSetIntakeDirection,
+        kWait,
+        kWaitForGoal
+    };
+
+    struct Instruction {
+        Opcode opcode;
+
+        // kDrive: 1 to quick turn. kElevatorGrab, kIntakeGrab, kStowIntake: 1
+        // to grab or stow. kSetIntakeDirection: an Elevator::IntakeMotorState.
+        uint8_t operand = 0;
+
+        // kDrive: seconds, throttle, and turn. kSetHeight: inches. kWait:
+        // seconds.
+        std::array<float, 3> args{};
+    };
+
+    /**
+     * Compiles a script.
+     *
+     * @param name   Name of the autonomous mode.
+     * @param source The script.
+     * @throws std::invalid_argument if the script has an error. The message
+     *         starts with the line number.
+     */
+    AutoScript(wpi::StringRef name, wpi::StringRef source);
+
+    /**
+     * Loads and compiles every .auto file in a directory. Each file's name
+     * without the extension is its autonomous mode's name.
+     *
+     * Files which can't be read or compiled are reported on the console and
+     * skipped, so a bad script can't keep the robot from starting. If the
+     * directory can't be read, that's reported too.
+     *
+     * @param directory The directory to load from.
+     */
+    static std::vector<AutoScript> LoadDirectory(wpi::StringRef directory);
+
+    /**
+     * Returns the name of the autonomous mode.
+     */
+    const std::string& GetName() const { return m_name; }
+
+    /**
+     * Returns the compiled instructions.
+     */
+    const std::vector<Instruction>& GetInstructions() const {
+        return m_instructions;
+    }
+
+private:
+    std::string m_name;
+    std::vector<Instruction> m_instructions;
+};
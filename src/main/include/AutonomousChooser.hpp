@@ -2,52 +2,104 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <initializer_list>
+#include <memory>
 #include <string>
-#include <thread>
 #include <vector>
 
 #include <frc/smartdashboard/Sendable.h>
 #include <frc/smartdashboard/SendableBuilder.h>
 #include <networktables/NetworkTableEntry.h>
-#include <wpi/StringMap.h>
+#include <units/time.h>
+#include <wpi/STLExtras.h>
 #include <wpi/StringRef.h>
-#include <wpi/condition_variable.h>
-#include <wpi/mutex.h>
+
+#include "Fiber.hpp"
+#include "LatencyHistogram.hpp"
 
 namespace frc3512 {
 
+/**
+ * Thrown from AutonomousChooser::YieldToMain() when autonomous has ended so the
+ * autonomous mode unwinds right away.
+ *
+ * Autonomous modes shouldn't catch it. It doesn't derive from std::exception
+ * so handlers for those don't catch it by accident.
+ */
+struct AutonomousCancelled {};
+
+/**
+ * A named autonomous mode for AutonomousChooser.
+ */
+struct AutonomousMode {
+    std::string name;
+    std::function<void()> func;
+};
+
 /**
  * A convenience wrapper around a SendableChooser for managing, selecting, and
  * running autonomous modes.
+ *
+ * The selected autonomous mode runs in a Fiber on the main robot thread, so
+ * YieldToMain() and AwaitRunAutonomous() are user-space context switches
+ * rather than thread handoffs.
+ *
+ * The fiber is a persistent worker created and started with the chooser, and
+ * its stack is touched in advance, so starting autonomous only hands the
+ * selected function to it. No allocation, stack mapping, or page faults land
+ * on the first autonomous tick.
+ *
+ * Each tick, the time the autonomous mode ran and the handoff latency (the
+ * rest of the time the main robot thread spent in AwaitRunAutonomous()) are
+ * recorded in histograms. They're reset when autonomous starts, so their
+ * maximums cover one match, and they're published with the chooser's
+ * Sendable entries.
+ *
+ * The autonomous modes are fixed at construction, and the selection is an
+ * index into them. The NetworkTables listener only stores the index, and
+ * starting autonomous only loads it, so the listener thread and the main
+ * robot thread never wait on each other.
+ *
+ * Autonomous modes wait with WaitUntil(), WaitFor(), and the other wait
+ * functions instead of looping on YieldToMain(). A waiting mode stays
+ * suspended while the main robot thread checks its condition each tick, so
+ * there's no context switch until the condition is met.
+ *
+ * A mode can run tasks concurrently with Parallel(), e.g., to raise the
+ * elevator while driving. Each task has its own fiber, but they're all stepped
+ * one after another from within AwaitRunAutonomous(), so subsystems can be
+ * shared between them without locking.
+ *
+ * Ending autonomous cancels the mode instead of waiting for it to notice: its
+ * pending YieldToMain() throws AutonomousCancelled, and its stack unwinds
+ * within the same call to EndAutonomous(). Since the mode runs on the main
+ * robot thread, there's no thread to join.
  */
 class AutonomousChooser : public frc::Sendable {
 public:
     /**
      * Constructs an AutonomousChooser.
      *
-     * Adds an autonomous mode that's run by default if no other autonomous mode
-     * is selected.
-     *
-     * @param name Name of autonomous mode.
-     * @param func Autonomous mode function.
+     * @param name  Name of the autonomous mode that's run if no other
+     *              autonomous mode is selected.
+     * @param func  Function of the default autonomous mode.
+     * @param modes The other autonomous modes.
      */
-    AutonomousChooser(wpi::StringRef name, std::function<void()> func);
+    AutonomousChooser(wpi::StringRef name, std::function<void()> func,
+                      std::vector<AutonomousMode> modes = {});
 
     ~AutonomousChooser();
 
-    /**
-     * Adds an autonomous mode.
-     *
-     * @param name Name of autonomous mode.
-     * @param func Autonomous mode function.
-     */
-    void AddAutonomous(wpi::StringRef name, std::function<void()> func);
-
     /**
      * Sets the selected autonomous mode for unit testing purposes.
      *
+     * Unknown names are ignored.
+     *
      * @param name Name of autonomous mode.
      */
     void SelectAutonomous(wpi::StringRef name);
@@ -57,58 +109,202 @@ public:
      */
     const std::vector<std::string>& GetAutonomousNames() const;
 
+    /**
+     * Returns true if an autonomous mode has started and hasn't returned or
+     * been cancelled.
+     */
+    bool IsAutonomousRunning() const;
+
     /**
      * Yield to main robot thread and wait for next chance to run.
      *
      * This function should only be called by the autonomous mode. A call by the
-     * main robot thread will block indefinitely.
+     * main robot thread does nothing.
+     *
+     * @throws AutonomousCancelled if autonomous ended while the mode was
+     *         waiting.
      */
     void YieldToMain();
 
     /**
-     * Return to main robot thread.
+     * Waits until the condition returns true.
+     *
+     * The wait functions should only be called by the autonomous mode. The
+     * condition is checked once immediately, then each tick by the main robot
+     * thread, so it should be cheap and shouldn't yield.
+     *
+     * @param condition The condition to wait for.
+     * @throws AutonomousCancelled if autonomous ended during the wait.
+     */
+    void WaitUntil(wpi::function_ref<bool()> condition);
+
+    /**
+     * Waits until the duration has passed.
+     *
+     * @param duration How long to wait.
+     * @throws AutonomousCancelled if autonomous ended during the wait.
+     */
+    void WaitFor(units::second_t duration);
+
+    /**
+     * Runs an action each tick until the duration has passed.
+     *
+     * This is for outputs that must be set every tick, like a drivetrain with
+     * motor safety enabled. The action runs once immediately, then each tick
+     * on the main robot thread.
+     *
+     * @param duration How long to wait.
+     * @param action   The action to run each tick.
+     * @throws AutonomousCancelled if autonomous ended during the wait.
+     */
+    void WaitFor(units::second_t duration, wpi::function_ref<void()> action);
+
+    /**
+     * Waits until the condition returns true or the timeout passes.
+     *
+     * @param condition The condition to wait for.
+     * @param timeout   The longest time to wait.
+     * @return True if the condition was met before the timeout.
+     * @throws AutonomousCancelled if autonomous ended during the wait.
+     */
+    bool WaitUntilWithTimeout(wpi::function_ref<bool()> condition,
+                              units::second_t timeout);
+
+    /**
+     * Waits until any of the conditions returns true.
+     *
+     * @param conditions The conditions to wait for. There must be at least one,
+     *                   since nothing could end the wait otherwise.
+     * @return The index of the first condition that was met. If several were
+     *         met in the same tick, the lowest index is returned.
+     * @throws std::invalid_argument if there are no conditions.
+     * @throws AutonomousCancelled if autonomous ended during the wait.
+     */
+    size_t Race(std::initializer_list<wpi::function_ref<bool()>> conditions);
+
+    /**
+     * Waits until each of the conditions has returned true.
+     *
+     * Conditions that returned true aren't checked again, so they don't have
+     * to be true at the same time.
      *
-     * This function should only be called by the autonomous mode.
+     * @param conditions The conditions to wait for. There can be at most 64.
+     * @throws std::invalid_argument if there are more than 64 conditions.
+     * @throws AutonomousCancelled if autonomous ended during the wait.
      */
-    void Return();
+    void All(std::initializer_list<wpi::function_ref<bool()>> conditions);
+
+    /**
+     * Runs the tasks concurrently and waits until they've all returned.
+     *
+     * Each task runs in its own fiber from a pool that's kept between calls.
+     * Each tick, the tasks whose waits are over are resumed in order, so they
+     * never run at the same time as each other or the main robot thread.
+     * Tasks wait with YieldToMain() and the wait functions like the mode does,
+     * and can call Parallel() themselves.
+     *
+     * If a task throws or autonomous ends, the tasks still running are
+     * cancelled, then the exception is rethrown from here.
+     *
+     * @param tasks The tasks to run.
+     * @throws AutonomousCancelled if autonomous ended before the tasks
+     *         returned.
+     */
+    void Parallel(std::initializer_list<wpi::function_ref<void()>> tasks);
 
     /**
      * Runs the selected autonomous mode function.
+     *
+     * The mode's first tick runs before this returns, so the caller should
+     * send any commands it made right after.
      */
     void AwaitStartAutonomous();
 
     /**
-     * Notify autonomous mode to run.
+     * Run autonomous mode until it yields.
      *
-     * This function should only be called by the main robot thread. It will
-     * block until the autonomous mode function waits to be run again. This
-     * ensures the main robot thread and autonomous mode won't race for
-     * resources.
+     * This function should only be called by the main robot thread. It
+     * returns when the autonomous mode function calls YieldToMain() or
+     * returns, so the main robot thread and autonomous mode never run at the
+     * same time.
      */
     void AwaitRunAutonomous();
 
     /**
-     * Notify autonomous mode so it can exit.
+     * Cancels autonomous mode.
+     *
+     * The mode is resumed once with YieldToMain() throwing
+     * AutonomousCancelled, so it unwinds without running another step. If it
+     * yields again anyway, the worker is replaced so the next autonomous mode
+     * can start. This should be called on leaving autonomous mode so that
+     * happens then instead of when autonomous starts.
      */
     void EndAutonomous();
 
     void InitSendable(frc::SendableBuilder& builder) override;
 
 private:
-    std::thread m_autonThread;
-    wpi::mutex m_mutex;
-    wpi::mutex m_autonMutex;
-    std::unique_lock<wpi::mutex> m_mainLock{m_autonMutex};
-    std::unique_lock<wpi::mutex> m_autonLock{m_autonMutex, std::defer_lock};
-    wpi::condition_variable m_cond;
-    bool m_awaitingAuton = false;
+    // A wait the autonomous mode is suspended in. Lives on the mode's stack.
+    struct Wait {
+        wpi::function_ref<bool()> condition;
+        wpi::function_ref<void()> action;
+        units::second_t deadline;
+        bool met = false;
+    };
+
+    // A fiber which can yield, and the wait it's suspended in, if any
+    struct TaskContext {
+        Fiber* fiber = nullptr;
+        Wait* wait = nullptr;
+    };
+
+    // A pooled fiber for running tasks forked by Parallel()
+    struct Task {
+        std::unique_ptr<Fiber> fiber;
+        TaskContext context;
+
+        // The function the fiber should run next
+        const wpi::function_ref<void()>* func = nullptr;
+
+        // Owned by a Parallel() call
+        bool inUse = false;
+
+        // The function hasn't returned
+        bool running = false;
+
+        // The function should be resumed on the next step
+        bool ready = false;
+    };
+
+    // Runs autonomous modes. Replaced if one doesn't exit when asked.
+    std::unique_ptr<Fiber> m_autonFiber;
+
+    // The autonomous mode the worker should run next
+    std::function<void()>* m_dispatchedAuton = nullptr;
+
+    // The autonomous mode's worker fiber and the wait it's suspended in. The
+    // main robot thread checks the wait instead of resuming the mode.
+    TaskContext m_modeContext;
+
+    // The fiber that's currently running, or m_modeContext if none is
+    TaskContext* m_current = &m_modeContext;
+
+    // Fibers for Parallel(). Tasks are never removed, so pointers to them stay
+    // valid.
+    std::vector<std::unique_ptr<Task>> m_tasks;
+
     bool m_autonRunning = false;
+    bool m_cancelRequested = false;
+    bool m_exiting = false;
 
-    std::string m_defaultChoice;
-    std::string m_selectedChoice;
-    wpi::StringMap<std::function<void()>> m_choices;
+    // Autonomous modes sorted by name. Never modified after construction, so
+    // any thread can read it without locking.
+    std::vector<AutonomousMode> m_modes;
     std::vector<std::string> m_names;
-    std::function<void()>* m_selectedAuton;
+    size_t m_defaultIndex = 0;
+
+    // Index into m_modes of the selected autonomous mode
+    std::atomic<size_t> m_selectedIndex{0};
 
     nt::NetworkTableEntry m_defaultEntry;
     nt::NetworkTableEntry m_optionsEntry;
@@ -116,6 +312,71 @@ private:
     nt::NetworkTableEntry m_activeEntry;
 
     NT_EntryListener m_selectedListenerHandle;
+
+    using Clock = std::chrono::steady_clock;
+
+    LatencyHistogram m_handoffHistogram;
+    LatencyHistogram m_bodyHistogram;
+    Clock::time_point m_resumeTime;
+    Clock::time_point m_bodyStartTime;
+    Clock::time_point m_bodyEndTime;
+
+    // How long the last EndAutonomous() which cancelled a mode took
+    double m_endUs = 0.0;
+
+    /**
+     * Returns the index of the named autonomous mode in m_modes, or
+     * m_modes.size() if there isn't one.
+     */
+    size_t FindAutonomous(wpi::StringRef name) const;
+
+    /**
+     * Suspends the autonomous mode in the wait until it's met or its deadline
+     * passes.
+     *
+     * @return True if the condition was met.
+     */
+    bool Park(Wait wait, bool checkFirst = true);
+
+    /**
+     * Checks whether the wait is over, and runs its action if it isn't.
+     *
+     * @return True if the wait is over.
+     */
+    static bool PollWait(Wait& wait);
+
+    /**
+     * Returns an idle task from the pool, creating one if needed, set up to
+     * run the function.
+     */
+    Task& AcquireTask(const wpi::function_ref<void()>& func);
+
+    /**
+     * Resumes the tasks which are ready.
+     *
+     * @return True if any of the tasks are still running.
+     */
+    bool StepTasks(const std::vector<Task*>& tasks);
+
+    /**
+     * Cancels the tasks which are still running and returns them to the pool.
+     */
+    void CancelTasks(const std::vector<Task*>& tasks);
+
+    // A task fiber's function
+    void RunTask(Task& task);
+
+    // Resumes the autonomous mode for one tick and records its timing
+    void RunTick();
+
+    /**
+     * Creates the worker fiber if there isn't a usable one and runs it until
+     * it waits for an autonomous mode.
+     */
+    void StartWorker();
+
+    // The worker fiber's function
+    void RunWorker();
 };
 
 }  // namespace frc3512
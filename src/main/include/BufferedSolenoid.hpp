@@ -0,0 +1,43 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <frc/Solenoid.h>
+
+/**
+ * A solenoid whose commands are sent once per tick.
+ *
+ * Like TalonSRXGroup, Set() only records the state, and Flush() sends it at
+ * the end of the tick if it differs from the last state sent. Get() returns
+ * the recorded state, so toggling reads back what was set earlier in the tick.
+ */
+class BufferedSolenoid {
+public:
+    /**
+     * Constructs a BufferedSolenoid on the default PCM.
+     *
+     * @param channel The solenoid's channel on the PCM.
+     */
+    explicit BufferedSolenoid(int channel);
+
+    /**
+     * Sets the state to send at the end of the tick.
+     */
+    void Set(bool on);
+
+    /**
+     * Returns the state last set.
+     */
+    bool Get() const;
+
+    /**
+     * Sends the state to the solenoid if it changed since it was last sent.
+     */
+    void Flush();
+
+private:
+    frc::Solenoid m_solenoid;
+
+    bool m_state;
+    bool m_sentState;
+};
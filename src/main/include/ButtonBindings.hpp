@@ -0,0 +1,171 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <vector>
+
+#include <hal/DriverStationTypes.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/STLExtras.h>
+#include <wpi/StringRef.h>
+
+#include "JoystickSnapshot.hpp"
+
+namespace wpi {
+class json;
+}  // namespace wpi
+
+/**
+ * A table of bindings from joystick triggers to teleop actions.
+ *
+ * Bindings are loaded from JSON like this:
+ *
+ * @code
+ * {
+ *     "bindings": [
+ *         {"stick": 2, "button": 1, "action": "toggleElevatorGrab"},
+ *         {"stick": 2, "button": 7, "action": "height", "height": "tote1"},
+ *         {"stick": 2, "button": 3, "on": "release", "action": "stackTotes"},
+ *         {"stick": 1, "pov": 90, "action": "toggleIntakeStow"},
+ *         {"stick": 2, "axis": 2, "above": 0.5, "action": "stackTotes"}
+ *     ]
+ * }
+ * @endcode
+ *
+ * "stick" is the joystick's port. The trigger is one of:
+ *
+ * - "button": fires when the button is pressed, or released if "on" is
+ *   "release"
+ * - "pov": fires when the POV hat moves to the angle. -1 is centered.
+ * - "axis": fires when the axis goes "above" or "below" the threshold
+ *
+ * The actions are toggleElevatorGrab, toggleIntakeGrab, toggleIntakeStow,
+ * toggleContainerGrab, toggleManualMode, stackTotes, and height (with a
+ * "height" preset from Elevator::FindHeightPreset()). Bindings only fire on
+ * edges, so they're for one-shot actions. Anything that should follow an
+ * input while it's held, like the intake wheels, is set from the snapshot
+ * every tick instead.
+ *
+ * The bindings are compiled into a flat array grouped by trigger, with an
+ * index from each button edge, POV angle, and axis to its bindings. Evaluating
+ * only visits the inputs that changed since the last snapshot, so the cost
+ * doesn't grow with the number of bindings.
+ */
+class ButtonBindings {
+public:
+    // The driver station's number of joystick ports
+    static constexpr size_t kMaxSticks = 6;
+
+    enum class Action : uint8_t {
+        kToggleElevatorGrab,
+        kToggleIntakeGrab,
+        kToggleIntakeStow,
+        kToggleContainerGrab,
+        kToggleManualMode,
+        kStackTotes,
+        kSetHeight
+    };
+
+    struct Binding {
+        Action action;
+
+        // Axis triggers: true if the binding fires above the threshold
+        bool above = false;
+
+        // kSetHeight: inches
+        float height = 0.f;
+
+        // Axis triggers: the threshold
+        float threshold = 0.f;
+    };
+
+    /**
+     * Constructs an empty table.
+     */
+    ButtonBindings() = default;
+
+    /**
+     * Compiles bindings from JSON.
+     *
+     * @param json The bindings.
+     * @throws std::invalid_argument if the JSON or a binding is invalid. The
+     *         message for a binding starts with its index.
+     */
+    explicit ButtonBindings(wpi::StringRef json);
+
+    /**
+     * Loads and compiles bindings from a JSON file.
+     *
+     * @param path The file's path.
+     * @throws std::invalid_argument if the file can't be read or is invalid.
+     */
+    static ButtonBindings Load(wpi::StringRef path);
+
+    /**
+     * Runs the actions of the bindings whose triggers fired.
+     *
+     * Actions run in order of joystick port, then pressed buttons, released
+     * buttons, the POV hat, and axes.
+     *
+     * @param sticks The joysticks, indexed by port. Bindings to ports past the
+     *               end are ignored.
+     * @param run    Called with each binding whose trigger fired.
+     */
+    void Evaluate(wpi::ArrayRef<const JoystickSnapshot*> sticks,
+                  wpi::function_ref<void(const Binding&)> run);
+
+    /**
+     * Records which axis triggers the joysticks are already past, so they
+     * don't fire until the axes leave and come back.
+     *
+     * @param sticks The joysticks, indexed by port.
+     */
+    void Prime(wpi::ArrayRef<const JoystickSnapshot*> sticks);
+
+    /**
+     * Returns the number of bindings.
+     */
+    size_t size() const { return m_bindings.size(); }
+
+private:
+    // A range of m_bindings
+    struct Range {
+        uint16_t begin = 0;
+        uint16_t end = 0;
+    };
+
+    // Index of one joystick's bindings by trigger
+    struct StickIndex {
+        std::array<Range, 32> pressed;
+        std::array<Range, 32> released;
+
+        // Centered, then 0 through 315 degrees in steps of 45
+        std::array<Range, 9> pov;
+
+        std::array<Range, HAL_kMaxJoystickAxes> axes;
+
+        // Axes which have bindings. Axis n is bit n.
+        uint32_t boundAxes = 0;
+    };
+
+    // Sorted by joystick, then trigger
+    std::vector<Binding> m_bindings;
+
+    // Whether each axis binding's axis was past its threshold. Only axis
+    // bindings' entries are used.
+    std::vector<uint8_t> m_axisActive;
+
+    std::array<StickIndex, kMaxSticks> m_sticks;
+
+    // Compiles the bindings in a parsed JSON document
+    void Compile(const wpi::json& document);
+
+    // Updates the axis bindings of an axis, calling run for each that fired
+    // if it isn't null
+    void EvaluateAxis(const Range& range, float value,
+                      wpi::function_ref<void(const Binding&)>* run);
+};
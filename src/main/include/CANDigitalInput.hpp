@@ -1,17 +1,40 @@
-// Copyright (c) 2020 FRC Team 3512. All Rights Reserved.
+// Copyright (c) 2020-2021 FRC Team 3512. All Rights Reserved.
 
 #include <ctre/phoenix/motorcontrol/SensorCollection.h>
 #include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+#include <hal/SimDevice.h>
 
 #pragma once
 
+/**
+ * A limit switch wired to a Talon SRX's reverse limit input.
+ *
+ * Like CANEncoder, the Talon is only read by Sample(), and Get() returns the
+ * last sample.
+ *
+ * In simulation, the switch is a SimDevice named
+ * "CANDigitalInput[<Talon ID>]" with a "value" a physics model sets.
+ */
 class CANDigitalInput {
 public:
     explicit CANDigitalInput(ctre::phoenix::motorcontrol::can::TalonSRX& motor);
 
-    bool Get();
+    /**
+     * Reads the limit switch from the Talon.
+     */
+    void Sample();
+
+    /**
+     * Returns true if the limit switch was closed at the last sample.
+     */
+    bool Get() const;
 
 private:
     ctre::phoenix::motorcontrol::can::TalonSRX& m_motor;
     ctre::phoenix::motorcontrol::SensorCollection m_sensor{m_motor};
+
+    bool m_value = false;
+
+    hal::SimDevice m_simDevice;
+    hal::SimBoolean m_simValue;
 };
@@ -3,20 +3,129 @@
 #pragma once
 
 #include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+#include <frc/smartdashboard/Sendable.h>
+#include <frc/smartdashboard/SendableBuilder.h>
+#include <frc/smartdashboard/SendableHelper.h>
+#include <hal/SimDevice.h>
+#include <units/time.h>
 
-class CANEncoder {
+#include "LatencyHistogram.hpp"
+
+/**
+ * A reading from a CANEncoder and when it was taken.
+ */
+struct EncoderSample {
+    // Distance in distance units
+    double distance = 0.0;
+
+    // Rate in distance units per second
+    double rate = 0.0;
+
+    // FPGA time when the roboRIO read the sample
+    units::second_t timestamp = 0_s;
+
+    // Estimated age of the Talon's measurement when the roboRIO read it
+    units::second_t age = 0_s;
+
+    // True if the measurement is older than CANEncoder::kMaxAge, so the rate
+    // can't be trusted to extrapolate with
+    bool stale = false;
+
+    /**
+     * Returns the distance extrapolated from the measurement to the given time
+     * with the measured rate, or the measured distance if the sample is stale.
+     *
+     * @param time FPGA time to predict the distance at.
+     */
+    double PredictDistance(units::second_t time) const {
+        if (stale) {
+            return distance;
+        }
+        return distance + rate * (time - timestamp + age).to<double>();
+    }
+};
+
+/**
+ * A quadrature encoder wired to a Talon SRX.
+ *
+ * The Talon is only read by Sample(), which should be called once at the start
+ * of each tick. GetDistance() and GetRate() return that sample, so every reader
+ * in a tick sees the same values without going back to the CTRE API.
+ *
+ * The readings come from the Talon's quadrature status frame, so they're
+ * already old when they're sampled. Phoenix doesn't timestamp status frames,
+ * so the age is estimated: if the readings changed since the last sample, a
+ * frame arrived since then and is on average half a frame period old, and if
+ * they didn't while the encoder is moving, the last frame has aged by the time
+ * between samples. Unchanged readings also happen when the encoder moves
+ * slower than a pulse per frame, or when frames stop arriving, so a sample
+ * older than kMaxAge is marked stale and isn't extrapolated. The ages are
+ * recorded in a histogram which is published with the encoder's Sendable
+ * entries.
+ *
+ * In simulation, the encoder is a SimDevice named "CANEncoder[<Talon ID>]"
+ * with "distance" and "rate" values in distance units, which a physics model
+ * sets instead of the Talon's sensor collection. Simulated samples are never
+ * old.
+ */
+class CANEncoder : public frc::Sendable,
+                   public frc::SendableHelper<CANEncoder> {
 public:
+    // The quadrature status frame period the encoder's Talon should use
+    static constexpr units::millisecond_t kStatusFramePeriod = 10_ms;
+
+    // The age past which a sample is stale. A few frame periods allows for
+    // frames delayed by bus traffic.
+    static constexpr units::millisecond_t kMaxAge = 3 * kStatusFramePeriod;
+
     CANEncoder(ctre::phoenix::motorcontrol::can::TalonSRX& motor,
                double distancePerPulse = 1.0, bool reverseDirection = false);
 
-    double GetDistance();
+    /**
+     * Reads the encoder's position and velocity from the Talon.
+     */
+    void Sample();
+
+    /**
+     * Returns the last sample.
+     */
+    const EncoderSample& GetSample() const { return m_sample; }
 
-    double GetRate();
+    /**
+     * Returns the distance from the last sample.
+     */
+    double GetDistance() const;
 
+    /**
+     * Returns the rate from the last sample.
+     */
+    double GetRate() const;
+
+    /**
+     * Zeroes the encoder and the distance from the last sample.
+     */
     void Reset();
 
+    /**
+     * Returns the histogram of sample ages.
+     */
+    const LatencyHistogram& GetAgeHistogram() const { return m_ageHistogram; }
+
+    void InitSendable(frc::SendableBuilder& builder) override;
+
 private:
     ctre::phoenix::motorcontrol::can::TalonSRX& m_motor;
 
     double m_distancePerPulse;
+
+    EncoderSample m_sample;
+    LatencyHistogram m_ageHistogram;
+
+    // The Talon's last raw readings, to tell when a new frame has arrived
+    int m_lastPosition = 0;
+    int m_lastVelocity = 0;
+
+    hal::SimDevice m_simDevice;
+    hal::SimDouble m_simDistance;
+    hal::SimDouble m_simRate;
 };
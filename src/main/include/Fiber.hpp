@@ -0,0 +1,103 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <exception>
+#include <functional>
+#include <memory>
+
+namespace frc3512 {
+
+/**
+ * A stackful coroutine.
+ *
+ * A fiber runs a function on its own stack, but on the thread which calls
+ * Resume(). The function runs until it calls Suspend() or returns, then
+ * Resume() returns. The next Resume() continues the function from where it
+ * suspended.
+ *
+ * Switching between the caller and the fiber only saves and restores
+ * callee-saved registers in user space, so unlike handing off between threads
+ * there are no system calls, wakeups, or scheduler latency. On x86-64 and ARM
+ * this is done with a small assembly routine, on Windows with the Win32 fiber
+ * API, and elsewhere with ucontext.
+ */
+class Fiber {
+public:
+    static constexpr size_t kDefaultStackSize = 256 * 1024;
+
+    /**
+     * Constructs a Fiber. The function doesn't run until Resume() is called.
+     *
+     * @param func      The function to run.
+     * @param stackSize Size of the fiber's stack in bytes.
+     */
+    explicit Fiber(std::function<void()> func,
+                   size_t stackSize = kDefaultStackSize);
+
+    /**
+     * Destroys the fiber and frees its stack.
+     *
+     * If the function is suspended partway through, objects on the fiber's
+     * stack aren't destroyed.
+     */
+    ~Fiber();
+
+    Fiber(const Fiber&) = delete;
+    Fiber& operator=(const Fiber&) = delete;
+
+    /**
+     * Runs the function until it calls Suspend() or returns.
+     *
+     * This should only be called from outside the fiber. Does nothing if the
+     * function has returned. If the function throws, the exception is
+     * rethrown from here.
+     */
+    void Resume();
+
+    /**
+     * Returns control to the caller of Resume().
+     *
+     * This should only be called from inside the fiber.
+     */
+    void Suspend();
+
+    /**
+     * Returns true if the function has returned.
+     */
+    bool IsFinished() const { return m_finished; }
+
+    /**
+     * Returns true if the fiber is currently executing, i.e., between a call
+     * to Resume() and the matching Suspend().
+     */
+    bool IsRunning() const { return m_running; }
+
+private:
+    // Platform-specific stack and saved registers
+    struct Context;
+
+    std::function<void()> m_func;
+    std::unique_ptr<Context> m_context;
+    std::exception_ptr m_exception;
+    bool m_running = false;
+    bool m_finished = false;
+
+    // Switches from the caller to the fiber
+    void SwitchIn();
+
+    // Switches from the fiber to the caller
+    void SwitchOut();
+
+    /**
+     * Runs the function on the fiber's stack, then switches out for the last
+     * time.
+     */
+    [[noreturn]] static void Main(Fiber* fiber);
+
+    friend struct FiberEntry;
+};
+
+}  // namespace frc3512
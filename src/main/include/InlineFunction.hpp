@@ -0,0 +1,133 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity = 2 * sizeof(void*)>
+class InlineFunction;
+
+/**
+ * A move-only replacement for std::function that stores the callable inside
+ * the object instead of on the heap.
+ *
+ * The callable must fit in Capacity bytes, which is checked at compile time.
+ * The default capacity holds a lambda that captures two pointers (e.g.,
+ * "this" and one reference). Calls go through a single function pointer
+ * instead of std::function's type-erased wrapper, and callables which are
+ * trivially copyable (the common case for lambdas capturing "this") are moved
+ * with a memcpy.
+ *
+ * @tparam R        Return type.
+ * @tparam Args     Argument types.
+ * @tparam Capacity Size in bytes of the inline storage.
+ */
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+public:
+    /**
+     * Constructs an empty InlineFunction.
+     */
+    InlineFunction() = default;
+
+    /**
+     * Constructs an InlineFunction holding the given callable.
+     *
+     * @param callable The callable object.
+     */
+    template <typename Callable,
+              typename = std::enable_if_t<!std::is_same_v<
+                  std::decay_t<Callable>, InlineFunction>>>
+    InlineFunction(Callable&& callable) {  // NOLINT(runtime/explicit)
+        using F = std::decay_t<Callable>;
+
+        static_assert(sizeof(F) <= Capacity,
+                      "Callable is too large for InlineFunction's storage");
+        static_assert(alignof(F) <= alignof(Storage),
+                      "Callable is overaligned for InlineFunction's storage");
+        static_assert(std::is_nothrow_move_constructible_v<F>,
+                      "Callable must be nothrow move constructible");
+
+        new (&m_storage) F(std::forward<Callable>(callable));
+        m_invoke = [](void* storage, Args... args) -> R {
+            return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+        };
+        if constexpr (!std::is_trivially_copyable_v<F> ||
+                      !std::is_trivially_destructible_v<F>) {
+            m_manage = [](void* dest, void* src) {
+                if (dest != nullptr) {
+                    new (dest) F(std::move(*static_cast<F*>(src)));
+                }
+                static_cast<F*>(src)->~F();
+            };
+        }
+    }
+
+    InlineFunction(InlineFunction&& rhs) noexcept { MoveFrom(rhs); }
+
+    InlineFunction& operator=(InlineFunction&& rhs) noexcept {
+        if (this != &rhs) {
+            Reset();
+            MoveFrom(rhs);
+        }
+        return *this;
+    }
+
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    ~InlineFunction() { Reset(); }
+
+    /**
+     * Returns true if a callable is stored.
+     */
+    explicit operator bool() const { return m_invoke != nullptr; }
+
+    /**
+     * Invokes the stored callable. The InlineFunction must not be empty.
+     */
+    R operator()(Args... args) const {
+        return m_invoke(&m_storage, std::forward<Args>(args)...);
+    }
+
+private:
+    using Storage =
+        std::aligned_storage_t<Capacity, alignof(std::max_align_t)>;
+
+    // Calls the callable in the given storage
+    using InvokeFunc = R (*)(void*, Args...);
+
+    /* Moves the callable in src into dest, then destroys the one in src. If
+     * dest is nullptr, only the destruction is performed. This is nullptr for
+     * trivial callables.
+     */
+    using ManageFunc = void (*)(void* dest, void* src);
+
+    mutable Storage m_storage;
+    InvokeFunc m_invoke = nullptr;
+    ManageFunc m_manage = nullptr;
+
+    void MoveFrom(InlineFunction& rhs) noexcept {
+        if (rhs.m_manage != nullptr) {
+            rhs.m_manage(&m_storage, &rhs.m_storage);
+        } else if (rhs.m_invoke != nullptr) {
+            std::memcpy(&m_storage, &rhs.m_storage, Capacity);
+        }
+        m_invoke = rhs.m_invoke;
+        m_manage = rhs.m_manage;
+        rhs.m_invoke = nullptr;
+        rhs.m_manage = nullptr;
+    }
+
+    void Reset() {
+        if (m_manage != nullptr) {
+            m_manage(nullptr, &m_storage);
+        }
+        m_invoke = nullptr;
+        m_manage = nullptr;
+    }
+};
@@ -0,0 +1,63 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+
+#include <hal/DriverStationTypes.h>
+
+/**
+ * The state of a joystick at the start of a tick.
+ *
+ * It's a plain struct with an interface like frc::Joystick's, so logic that
+ * reads it can also be given synthetic inputs. Buttons are numbered from 1 and
+ * button n is bit n - 1 of the masks, like in the HAL.
+ */
+struct JoystickSnapshot {
+    std::array<float, HAL_kMaxJoystickAxes> axes{};
+
+    // Buttons which are down
+    uint32_t buttons = 0;
+
+    // Buttons which went down or up since the last snapshot
+    uint32_t pressed = 0;
+    uint32_t released = 0;
+
+    // Axes whose values changed since the last snapshot. Axis n is bit n.
+    uint32_t axesChanged = 0;
+
+    // Angle of the first POV hat in degrees, or -1 if it isn't pressed
+    int pov = -1;
+    bool povChanged = false;
+
+    /**
+     * Reads a joystick from the driver station.
+     *
+     * Each of the axes, buttons, and POV hats is read with one HAL call, so
+     * the driver station's lock is taken three times per joystick rather than
+     * once per query.
+     *
+     * @param port The joystick's port.
+     * @param last The last snapshot of the joystick, for finding edges.
+     */
+    static JoystickSnapshot Read(int port, const JoystickSnapshot& last);
+
+    /**
+     * Sets the button edges and which axes and POV hat changed by comparing
+     * with the last snapshot.
+     *
+     * Read() calls this. Synthetic snapshots can call it after setting the
+     * axes, buttons, and POV hat.
+     */
+    void FindChanges(const JoystickSnapshot& last);
+
+    double GetX() const;
+    double GetY() const;
+    double GetRawAxis(int axis) const;
+    bool GetRawButton(int button) const;
+    bool GetRawButtonPressed(int button) const;
+    bool GetRawButtonReleased(int button) const;
+    int GetPOV() const { return pov; }
+};
@@ -0,0 +1,73 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <vector>
+
+/**
+ * A histogram of durations with fixed, power-of-two buckets.
+ *
+ * Bucket 0 counts durations under 1 us, and bucket i counts durations in
+ * [2^(i - 1), 2^i) us. The last bucket also counts everything longer.
+ * Recording a sample never allocates, so it's cheap enough to leave on in the
+ * robot loop.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 18;
+
+    /**
+     * Records a duration.
+     *
+     * @param nanoseconds The duration in nanoseconds.
+     */
+    void Record(int64_t nanoseconds);
+
+    /**
+     * Clears all samples.
+     */
+    void Reset();
+
+    /**
+     * Returns the number of samples in each bucket.
+     */
+    const std::array<uint32_t, kBuckets>& GetBuckets() const {
+        return m_buckets;
+    }
+
+    /**
+     * Returns the bucket counts as doubles for NetworkTables.
+     */
+    std::vector<double> GetBucketsAsDoubles() const;
+
+    /**
+     * Returns the number of samples.
+     */
+    uint32_t GetCount() const { return m_count; }
+
+    /**
+     * Returns the most recent sample in microseconds.
+     */
+    double GetLastUs() const { return m_lastNs / 1e3; }
+
+    /**
+     * Returns the longest sample in microseconds.
+     */
+    double GetMaxUs() const { return m_maxNs / 1e3; }
+
+    /**
+     * Returns the mean sample in microseconds, or 0 if there are none.
+     */
+    double GetMeanUs() const;
+
+private:
+    std::array<uint32_t, kBuckets> m_buckets{};
+    uint32_t m_count = 0;
+    int64_t m_lastNs = 0;
+    int64_t m_maxNs = 0;
+    int64_t m_totalNs = 0;
+};
@@ -2,10 +2,16 @@
 
 #pragma once
 
-#include <frc/Joystick.h>
+#include <vector>
+
 #include <frc/TimedRobot.h>
 
+#include "AutoScript.hpp"
 #include "AutonomousChooser.hpp"
+#include "ButtonBindings.hpp"
+#include "JoystickSnapshot.hpp"
+#include "StatusFrameBudget.hpp"
+#include "TransitionTraceLogger.hpp"
 #include "subsystems/Drivetrain.hpp"
 #include "subsystems/Elevator.hpp"
 
@@ -14,14 +20,35 @@
  */
 class Robot : public frc::TimedRobot {
 public:
+    // The joysticks at the start of a teleop tick
+    struct Inputs {
+        JoystickSnapshot driveStick1;
+        JoystickSnapshot driveStick2;
+        JoystickSnapshot appendageStick;
+    };
+
     Drivetrain drivetrain;
     Elevator elevator;
 
     Robot();
+    void RobotPeriodic() override;
+    void DisabledInit() override;
+    void TeleopInit() override;
     void TeleopPeriodic() override;
     void AutonomousInit() override;
     void AutonomousPeriodic() override;
 
+    // Runs one tick of teleop against a snapshot of the joysticks
+    void RunTeleop(const Inputs& snapshot);
+
+    // Returns the direction the intake should run while the joysticks are held
+    // as in the snapshot, or stopped if no direction is held
+    static Elevator::IntakeMotorState GetIntakeDirection(
+        const Inputs& snapshot);
+
+    // Returns the autonomous chooser so simulations can select and watch modes
+    frc3512::AutonomousChooser& GetAutonomousChooser() { return autonChooser; }
+
     // Drives forward
     void AutoDriveForward();
 
@@ -40,10 +67,57 @@ public:
     // Drives forward and picks up one tote
     void AutoOneTote();
 
+    // Runs an autonomous mode loaded from a script
+    void AutoRunScript(const AutoScript& script);
+
 private:
-    frc::Joystick driveStick1{0};
-    frc::Joystick driveStick2{1};
-    frc::Joystick appendageStick{2};
+    static constexpr int kDriveStick1Port = 0;
+    static constexpr int kDriveStick2Port = 1;
+    static constexpr int kAppendageStickPort = 2;
+
+    // Name of the autonomous mode that does nothing, which is the default
+    static constexpr const char* kDefaultModeName = "No-op";
+
+    // The subsystems' Talons' status frame periods, which are set again when a
+    // Talon resets
+    StatusFrameBudget statusFrames;
+
+    // The last snapshot of the joysticks, which the next one finds edges from
+    Inputs inputs;
+
+    // Teleop's button bindings from the deploy directory
+    ButtonBindings bindings = LoadBindings();
+
+    // Autonomous scripts from the deploy directory. Not modified after
+    // construction, since autonChooser refers to them.
+    std::vector<AutoScript> autoScripts = LoadAutoScripts();
+
+    frc3512::AutonomousChooser autonChooser{kDefaultModeName, [] {},
+                                            MakeAutonomousModes()};
+
+    // Logs state machine transitions for diagnosing them after a match
+    TransitionTraceLogger traceLogger;
+
+    // Reads all the subsystems' CAN sensors once, so the whole tick sees the
+    // same values
+    void SampleSensors();
+
+    // Sends the subsystems' actuator commands which changed this tick
+    void FlushOutputs();
+
+    // Reads all the joysticks once
+    Inputs ReadInputs() const;
+
+    // Runs a button binding's action
+    void RunBinding(const ButtonBindings::Binding& binding);
+
+    // Loads bindings.json from the deploy directory, or returns the built-in
+    // bindings if it can't be loaded
+    static ButtonBindings LoadBindings();
+
+    // Loads the scripts in the autonomous folder of the deploy directory
+    static std::vector<AutoScript> LoadAutoScripts();
 
-    frc3512::AutonomousChooser autonChooser{"No-op", [] {}};
+    // Returns the built-in autonomous modes and one for each script
+    std::vector<frc3512::AutonomousMode> MakeAutonomousModes();
 };
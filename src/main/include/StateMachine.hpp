@@ -1,12 +1,16 @@
-// Copyright (c) 2015-2020 FRC Team 3512. All Rights Reserved.
+// Copyright (c) 2015-2021 FRC Team 3512. All Rights Reserved.
 
 #pragma once
 
+#include <stddef.h>
+
+#include <deque>
 #include <string>
-#include <utility>
-#include <vector>
+
+#include <wpi/StringMap.h>
 
 #include "State.hpp"
+#include "TypedStateMachine.hpp"
 
 /* The default state is "IDLE". States that end the state machine should return
  * "IDLE" from transition(). Call run() periodically to operate the state
@@ -15,19 +19,32 @@
 
 /**
  * Provides an easier way to create state machines
+ *
+ * This is a thin adapter over TypedStateMachine which maps state names to
+ * indices once when states are added. New code should prefer
+ * TypedStateMachine with an enum of states.
  */
 class StateMachine : public State {
 public:
+    using Snapshot = TypedStateMachine<size_t>::Snapshot;
+
     explicit StateMachine(std::string name);
 
-    StateMachine(StateMachine&&) = default;
-    StateMachine& operator=(StateMachine&&) = default;
+    // The run() callable and the states' adapters capture "this"
+    StateMachine(const StateMachine&) = delete;
+    StateMachine& operator=(const StateMachine&) = delete;
 
     /**
      * Ownership of 'state' will be transferred to this class, which will handle
      * destroying it.
      */
-    void AddState(State&& state) { m_states.push_back(std::move(state)); }
+    void AddState(State&& state);
+
+    /**
+     * Adds a state nested inside the named parent state, which must be added
+     * first. The first child added to a state is entered when it is.
+     */
+    void AddState(State&& state, const std::string& parent);
 
     /* Moves the state machine to the given state. If the next state is found,
      * std::exit() for the current state and entry() for the next state are
@@ -39,7 +56,30 @@ public:
     // Returns name of current state
     const std::string GetState() const;
 
+    /**
+     * Returns a snapshot of the state machine's progress. See
+     * TypedStateMachine::Save().
+     */
+    Snapshot Save() const;
+
+    /**
+     * Restores progress saved by Save() without calling exit() or entry(). See
+     * TypedStateMachine::Restore().
+     */
+    bool Restore(const Snapshot& snapshot);
+
+    /**
+     * Returns the record of this state machine's transitions. State IDs in it
+     * are indices into the order states were added.
+     */
+    TransitionTrace& GetTrace();
+
 private:
-    std::vector<State> m_states;
-    const State* m_currentState = nullptr;
+    // std::deque doesn't invalidate references to elements on push_back()
+    std::deque<State> m_states;
+    wpi::StringMap<size_t> m_indices;
+    TypedStateMachine<size_t> m_machine;
+
+    // Stores the state and wraps its callables for m_machine
+    TypedState<size_t> Adapt(State&& state);
 };
@@ -0,0 +1,144 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <array>
+#include <initializer_list>
+#include <vector>
+
+#include <ctre/phoenix/motorcontrol/StatusFrame.h>
+#include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
+#include <units/time.h>
+
+/**
+ * Sets the status frame periods of the robot's Talon SRXs from the signals the
+ * subsystems need, and estimates the CAN bus load they cause.
+ *
+ * By default a Talon streams every status frame whether or not anything reads
+ * it, while the quadrature frame CANEncoder reads only comes every 160 ms.
+ * Subsystems declare each Talon with the frames they read and how often, and
+ * every other frame is slowed to the longest period the Talon allows.
+ *
+ * A Talon goes back to its default periods when it resets, such as after a
+ * brownout, so ReapplyIfReset() should be called periodically to restore them.
+ *
+ * The bus load counts each Talon's status frames and the control frame it
+ * receives. It's an estimate for the Talons' share of the bus, so the budget
+ * should leave room for the PDP, the PCM, and retransmissions.
+ */
+class StatusFrameBudget {
+public:
+    using Frame = ctre::phoenix::motorcontrol::StatusFrameEnhanced;
+
+    // A status frame a subsystem reads and the longest period it can use
+    struct Need {
+        Frame frame;
+        units::millisecond_t period;
+    };
+
+    // The longest status frame period a Talon accepts
+    static constexpr units::millisecond_t kSlowestPeriod = 255_ms;
+
+    // The fraction of the bus the Talons may use by default
+    static constexpr double kDefaultMaxBusLoad = 0.3;
+
+    /**
+     * Constructs a StatusFrameBudget.
+     *
+     * @param maxBusLoad The fraction of the bus the Talons may use.
+     */
+    explicit StatusFrameBudget(double maxBusLoad = kDefaultMaxBusLoad);
+
+    /**
+     * Declares a Talon and the status frames read from it.
+     *
+     * A Talon's frames that aren't listed are sent at kSlowestPeriod. If a
+     * Talon is declared more than once, each frame gets the shortest period
+     * asked for.
+     *
+     * @param talon The Talon.
+     * @param needs The status frames read from it.
+     * @throws std::invalid_argument if a frame isn't one the budget manages
+     *         or a period isn't between 1 ms and kSlowestPeriod.
+     */
+    void Add(ctre::phoenix::motorcontrol::can::TalonSRX& talon,
+             std::initializer_list<Need> needs = {});
+
+    /**
+     * Returns the estimated fraction of the bus the declared Talons use.
+     */
+    double GetBusLoad() const;
+
+    /**
+     * Returns the estimated fraction of the bus the declared Talons would use
+     * with the default status frame periods.
+     */
+    double GetDefaultBusLoad() const;
+
+    /**
+     * Sets the declared Talons' status frame periods, then prints the bus load
+     * and a warning if it's over budget.
+     *
+     * This doesn't wait for the Talons to acknowledge, so it doesn't hold up
+     * startup or simulation when they aren't on the bus.
+     */
+    void Apply();
+
+    /**
+     * Sets the status frame periods again on each declared Talon which has
+     * reset since the last call, and prints which ones did.
+     *
+     * The reset flag comes from the Talon's general status frame, so checking
+     * it doesn't wait on the bus.
+     *
+     * @return The number of Talons which had reset.
+     */
+    size_t ReapplyIfReset();
+
+private:
+    // A status frame the budget manages and the Talon's default period for it
+    struct ManagedFrame {
+        Frame frame;
+        units::millisecond_t defaultPeriod;
+    };
+
+    static constexpr std::array<ManagedFrame, 9> kFrames{
+        {{Frame::Status_1_General, 10_ms},
+         {Frame::Status_2_Feedback0, 20_ms},
+         {Frame::Status_3_Quadrature, 160_ms},
+         {Frame::Status_4_AinTempVbat, 160_ms},
+         {Frame::Status_8_PulseWidth, 160_ms},
+         {Frame::Status_10_Targets, 160_ms},
+         {Frame::Status_12_Feedback1, 160_ms},
+         {Frame::Status_13_Base_PIDF0, 160_ms},
+         {Frame::Status_14_Turn_PIDF1, 160_ms}}};
+
+    // The period of the control frame each Talon receives
+    static constexpr units::millisecond_t kControlFramePeriod = 10_ms;
+
+    // An extended data frame with 8 data bytes is 131 bits plus 3 bits of
+    // interframe space. Bit stuffing adds around 10% on typical data.
+    static constexpr double kBitsPerFrame = 150.0;
+
+    static constexpr double kBitRate = 1e6;
+
+    // A period for each of kFrames
+    using Periods = std::array<units::millisecond_t, kFrames.size()>;
+
+    struct Device {
+        ctre::phoenix::motorcontrol::can::TalonSRX* talon;
+        Periods periods;
+    };
+
+    std::vector<Device> m_devices;
+    double m_maxBusLoad;
+
+    // Returns the bus load of a Talon sending status frames at the periods
+    static double DeviceBusLoad(const Periods& periods);
+
+    // Sets a Talon's status frame periods without waiting for it to
+    // acknowledge
+    static void ApplyPeriods(const Device& device);
+};
@@ -4,14 +4,34 @@
 
 #include <ctre/phoenix/motorcontrol/can/TalonSRX.h>
 #include <frc/SpeedController.h>
+#include <hal/SimDevice.h>
 
+/**
+ * A Talon SRX leader and its followers driven as one speed controller.
+ *
+ * Set() only records the output. Flush() sends it to the leader at the end of
+ * the tick, and only if it differs from the last output sent, so setting the
+ * same output every tick costs no CAN traffic. Disable() and StopMotor() send
+ * right away since motor safety calls them when the robot loop has stalled.
+ *
+ * In simulation, the group is a SimDevice named "TalonSRXGroup[<leader ID>]"
+ * with a read-only "output" value, the percent output sent to the leader after
+ * inversion, for a physics model to read. It's updated when the output is
+ * sent.
+ */
 class TalonSRXGroup : public frc::SpeedController {
 public:
     template <class... Talons>
     explicit TalonSRXGroup(ctre::phoenix::motorcontrol::can::TalonSRX& leader,
                            Talons&... followers)
-        : m_leader{&leader} {
-        FollowImpl(followers...);
+        : m_leader{&leader},
+          m_simDevice{"TalonSRXGroup", leader.GetDeviceID()} {
+        if (m_simDevice) {
+            m_simOutput = m_simDevice.CreateDouble("output", true, 0.0);
+        }
+        if constexpr (sizeof...(followers) > 0) {
+            FollowImpl(followers...);
+        }
     }
 
     TalonSRXGroup(TalonSRXGroup&&) = default;
@@ -25,11 +45,27 @@ public:
     void StopMotor() override;
     void PIDWrite(double output) override;
 
+    /**
+     * Sends the output to the leader if it changed since it was last sent.
+     */
+    void Flush();
+
 private:
     double m_speed = 0.0;
     bool m_isInverted = false;
+
+    // The leader's percent output after inversion, and the last one sent
+    double m_output = 0.0;
+    double m_sentOutput = 0.0;
+
     ctre::phoenix::motorcontrol::can::TalonSRX* m_leader;
 
+    hal::SimDevice m_simDevice;
+    hal::SimDouble m_simOutput;
+
+    // Sends a percent output to the leader
+    void SendOutput(double output);
+
     template <class Talon, class... Talons>
     void FollowImpl(Talon& follower, Talons&... followers) {
         follower.Follow(*m_leader);
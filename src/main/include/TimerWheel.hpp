@@ -0,0 +1,141 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <vector>
+
+/**
+ * A hierarchical timer wheel which measures time in ticks.
+ *
+ * Timers are identified by a small integer ID chosen by the owner (e.g., a
+ * state's index), so scheduling and canceling never allocate. Each level of
+ * the wheel has kSlots slots, and a timer is filed in the lowest level whose
+ * range covers its delay. Timers in higher levels cascade down as the wheel
+ * turns. Advancing one tick costs O(1) plus the number of timers expiring or
+ * cascading on that tick, regardless of how many timers are pending.
+ */
+class TimerWheel {
+public:
+    static constexpr int kSlotBits = 6;
+    static constexpr int kSlots = 1 << kSlotBits;
+    static constexpr int kLevels = 3;
+
+    /**
+     * The longest delay in ticks that can be scheduled. Longer delays are
+     * clamped to this.
+     */
+    static constexpr uint64_t kMaxDelay =
+        (uint64_t{1} << (kSlotBits * kLevels)) - 1;
+
+    /**
+     * Constructs a TimerWheel.
+     *
+     * @param capacity Number of timer IDs, in [0, capacity).
+     */
+    explicit TimerWheel(size_t capacity = 0);
+
+    /**
+     * Sets the number of timer IDs. Call this before scheduling timers, since
+     * it allocates.
+     *
+     * @param capacity Number of timer IDs, in [0, capacity).
+     */
+    void Reserve(size_t capacity);
+
+    /**
+     * Schedules a timer to expire after the given number of ticks. If the
+     * timer is already scheduled, it's rescheduled.
+     *
+     * @param id    ID of the timer.
+     * @param delay Number of calls to Advance() after which the timer expires.
+     *              A delay of zero is treated as one.
+     */
+    void Schedule(size_t id, uint64_t delay);
+
+    /**
+     * Cancels a timer. Does nothing if the timer isn't scheduled.
+     *
+     * @param id ID of the timer.
+     */
+    void Cancel(size_t id);
+
+    /**
+     * Returns true if the timer is scheduled.
+     *
+     * @param id ID of the timer.
+     */
+    bool IsScheduled(size_t id) const;
+
+    /**
+     * Returns the number of calls to Advance() until the timer expires, or 0
+     * if it isn't scheduled.
+     *
+     * @param id ID of the timer.
+     */
+    uint64_t GetRemaining(size_t id) const;
+
+    /**
+     * Returns the number of times Advance() has been called.
+     */
+    uint64_t GetTick() const { return m_tick; }
+
+    /**
+     * Advances the wheel by one tick and calls onExpire(id) for each timer
+     * which expired.
+     *
+     * Timers expire in no particular order. onExpire may schedule or cancel
+     * timers.
+     */
+    template <typename F>
+    void Advance(F&& onExpire) {
+        ++m_tick;
+
+        // Move timers from higher levels whose expiries are now in range
+        for (int level = 1; level < kLevels; ++level) {
+            if ((m_tick & ((uint64_t{1} << (kSlotBits * level)) - 1)) != 0) {
+                break;
+            }
+            Cascade(level);
+        }
+
+        auto& head = m_slots[m_tick & (kSlots - 1)];
+        while (head != kNone) {
+            int32_t id = head;
+            Unlink(id);
+            onExpire(static_cast<size_t>(id));
+        }
+    }
+
+private:
+    static constexpr int32_t kNone = -1;
+
+    struct Node {
+        uint64_t expiry = 0;
+        int32_t prev = kNone;
+        int32_t next = kNone;
+
+        // Index into m_slots of the list containing this timer
+        int32_t slot = kNone;
+    };
+
+    std::vector<Node> m_nodes;
+
+    // Heads of each slot's doubly linked list of timers, one level after
+    // another
+    std::array<int32_t, kLevels * kSlots> m_slots;
+
+    uint64_t m_tick = 0;
+
+    // Files a timer in the slot matching its expiry
+    void Insert(int32_t id);
+
+    // Removes a timer from its slot
+    void Unlink(int32_t id);
+
+    // Refiles every timer in the current slot of the given level
+    void Cascade(int level);
+};
@@ -0,0 +1,147 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+
+/**
+ * One state transition recorded by a TransitionTrace.
+ */
+struct TransitionRecord {
+    // Time of the transition in microseconds (wpi::Now())
+    uint64_t timestamp = 0;
+
+    // Number of calls to the state machine's Run() before the transition
+    uint32_t tick = 0;
+
+    // State IDs, or kNoState when there wasn't one
+    uint16_t from = 0;
+    uint16_t to = 0;
+
+    static constexpr uint16_t kNoState = UINT16_MAX;
+};
+
+/**
+ * A fixed-size ring buffer of state transitions.
+ *
+ * The state machine's thread records transitions with Record(), which never
+ * locks or allocates. Another thread (e.g., a TransitionTraceLogger) removes
+ * them with Drain(). If the consumer falls behind, the oldest records are
+ * overwritten and counted as dropped, so the control loop never waits on it.
+ *
+ * Each slot is guarded by a sequence number which is odd while the slot is
+ * being written. The consumer rereads it after copying a record and discards
+ * the copy if the producer overwrote the slot in the meantime.
+ *
+ * There may be only one producer and one consumer at a time.
+ */
+class TransitionTrace {
+public:
+    static constexpr size_t kCapacity = 256;
+
+    /**
+     * Records a transition. Called by the state machine.
+     *
+     * @param timestamp Time of the transition in microseconds.
+     * @param tick      Number of calls to Run() before the transition.
+     * @param from      ID of the previous state.
+     * @param to        ID of the next state.
+     */
+    void Record(uint64_t timestamp, uint32_t tick, uint16_t from, uint16_t to) {
+        uint64_t index = m_writeIndex.load(std::memory_order_relaxed);
+        auto& slot = m_slots[index % kCapacity];
+
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.timestamp.store(timestamp, std::memory_order_relaxed);
+        slot.packed.store(Pack(tick, from, to), std::memory_order_relaxed);
+
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        m_writeIndex.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * Removes every record written since the last call and passes each one to
+     * onRecord(const TransitionRecord&), oldest first.
+     *
+     * @return The number of records passed to onRecord.
+     */
+    template <typename F>
+    size_t Drain(F&& onRecord) {
+        uint64_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+        if (writeIndex - m_readIndex > kCapacity) {
+            m_dropped += writeIndex - m_readIndex - kCapacity;
+            m_readIndex = writeIndex - kCapacity;
+        }
+
+        size_t count = 0;
+        for (; m_readIndex < writeIndex; ++m_readIndex) {
+            const auto& slot = m_slots[m_readIndex % kCapacity];
+
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            TransitionRecord record;
+            record.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+            Unpack(slot.packed.load(std::memory_order_relaxed), record);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence != 2 * m_readIndex + 2 ||
+                slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                // The producer lapped the consumer while the slot was read
+                ++m_dropped;
+                continue;
+            }
+
+            onRecord(record);
+            ++count;
+        }
+
+        return count;
+    }
+
+    /**
+     * Returns the total number of records written.
+     */
+    uint64_t GetWritten() const {
+        return m_writeIndex.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of records overwritten before Drain() reached them.
+     *
+     * This should only be called by the consumer.
+     */
+    uint64_t GetDropped() const { return m_dropped; }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> timestamp{0};
+
+        // Tick, from, and to packed so the record is two words
+        std::atomic<uint64_t> packed{0};
+    };
+
+    std::array<Slot, kCapacity> m_slots;
+
+    // Written by the producer only
+    std::atomic<uint64_t> m_writeIndex{0};
+
+    // Used by the consumer only
+    uint64_t m_readIndex = 0;
+    uint64_t m_dropped = 0;
+
+    static constexpr uint64_t Pack(uint32_t tick, uint16_t from, uint16_t to) {
+        return (uint64_t{tick} << 32) | (uint64_t{from} << 16) | to;
+    }
+
+    static void Unpack(uint64_t packed, TransitionRecord& record) {
+        record.tick = static_cast<uint32_t>(packed >> 32);
+        record.from = static_cast<uint16_t>(packed >> 16);
+        record.to = static_cast<uint16_t>(packed);
+    }
+};
@@ -0,0 +1,101 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <networktables/NetworkTableEntry.h>
+#include <units/time.h>
+#include <wpi/StringRef.h>
+#include <wpi/condition_variable.h>
+#include <wpi/mutex.h>
+
+#include "TransitionTrace.hpp"
+
+/**
+ * Drains state machines' TransitionTraces on a background thread.
+ *
+ * Records are appended to a binary file in the operating directory
+ * (/home/lvuser on the roboRIO) so stalls can be diagnosed after a match, and
+ * each machine's latest transition is published to NetworkTables under
+ * "Transitions/<name>" as [timestamp, from, to, tick].
+ *
+ * The file starts with the magic "SMTRACE1", a uint32_t machine count, and
+ * each machine's name as a uint32_t length followed by its characters. The
+ * rest of the file is FileRecords. Integers use the robot's byte order.
+ */
+class TransitionTraceLogger {
+public:
+    struct FileRecord {
+        uint64_t timestamp;
+        uint32_t tick;
+        uint16_t from;
+        uint16_t to;
+
+        // Index of the machine in the order it was added
+        uint32_t machine;
+
+        // Records of this machine dropped so far
+        uint32_t dropped;
+    };
+
+    /**
+     * Constructs a TransitionTraceLogger.
+     *
+     * @param filename Name of the log file in the operating directory.
+     * @param period   How often the traces are drained.
+     */
+    explicit TransitionTraceLogger(wpi::StringRef filename = "transitions.bin",
+                                   units::second_t period = 100_ms);
+
+    ~TransitionTraceLogger();
+
+    TransitionTraceLogger(const TransitionTraceLogger&) = delete;
+    TransitionTraceLogger& operator=(const TransitionTraceLogger&) = delete;
+
+    /**
+     * Adds a trace to drain. Call this before Start().
+     *
+     * @param name  Name of the state machine.
+     * @param trace The state machine's trace, which must outlive this object.
+     */
+    void AddTrace(wpi::StringRef name, TransitionTrace& trace);
+
+    /**
+     * Opens the log file and starts the background thread.
+     */
+    void Start();
+
+    /**
+     * Stops the background thread after one last drain and closes the log
+     * file.
+     */
+    void Stop();
+
+private:
+    struct Source {
+        std::string name;
+        TransitionTrace* trace;
+        nt::NetworkTableEntry entry;
+    };
+
+    std::string m_path;
+    units::second_t m_period;
+    std::vector<Source> m_sources;
+    FILE* m_file = nullptr;
+
+    std::thread m_thread;
+    wpi::mutex m_mutex;
+    wpi::condition_variable m_cond;
+    bool m_running = false;
+
+    void WriteHeader();
+
+    // Drains every trace once
+    void DrainAll();
+};
@@ -0,0 +1,75 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <optional>
+
+#include <units/time.h>
+
+#include "InlineFunction.hpp"
+
+/**
+ * Defines a state in a TypedStateMachine.
+ *
+ * Unlike State, transitions are expressed as state IDs instead of names, so
+ * the state machine can dispatch them with an array lookup. The callables are
+ * stored inline rather than in std::function, so each one may capture at most
+ * two pointers (e.g., "this" and one reference). Larger captures fail to
+ * compile.
+ *
+ * @tparam StateID Enum (or integral type) identifying each state.
+ */
+template <typename StateID>
+class TypedState {
+public:
+    /**
+     * The result of transition(). An empty value maintains the current state.
+     */
+    using Transition = std::optional<StateID>;
+
+    /**
+     * Value of events which makes the state machine poll transition() every
+     * tick.
+     */
+    static constexpr uint32_t kPollEveryTick = UINT32_MAX;
+
+    TypedState() = default;
+
+    TypedState(TypedState&&) = default;
+    TypedState& operator=(TypedState&&) = default;
+
+    // entry() is run when the state is first transitioned to.
+    InlineFunction<void()> entry = [] {};
+
+    /* transition() transitions the state of the state machine to the state
+     * with the ID returned. If an empty Transition is returned, the current
+     * state will be maintained.
+     */
+    InlineFunction<Transition()> transition = [] { return Transition{}; };
+
+    /* Bitmask of the events posted with TypedStateMachine::PostEvent() which
+     * can make transition() return a state. transition() is evaluated once
+     * after the state is entered, then only on ticks where one of these events
+     * was posted. If this is kPollEveryTick, transition() is polled every tick
+     * instead. States which only leave via their timeout should set this to
+     * zero.
+     */
+    uint32_t events = kPollEveryTick;
+
+    /* If nonzero, the state machine moves to timeoutState once the state has
+     * been active for this long, unless transition() moved it first. The
+     * timeout is rounded up to a whole number of state machine periods.
+     */
+    units::second_t timeout = 0_s;
+
+    // The state to move to when the timeout elapses
+    StateID timeoutState{};
+
+    // run() is run while the state machine is in that state.
+    InlineFunction<void()> run = [] {};
+
+    // exit() is run when the state is being transitioned away from.
+    InlineFunction<void()> exit = [] {};
+};
@@ -0,0 +1,616 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+#include <units/time.h>
+#include <wpi/timestamp.h>
+
+#include "TimerWheel.hpp"
+#include "TransitionTrace.hpp"
+#include "TypedState.hpp"
+
+/**
+ * A state machine whose states are identified by an enum instead of a string.
+ *
+ * The states are stored in a table indexed by their ID, so the table is built
+ * once while states are added and Run() does no heap allocation or string
+ * comparisons. A transition is a single array lookup.
+ *
+ * States are added with AddState() during construction of the owning
+ * subsystem. Call Run() periodically to operate the state machine.
+ *
+ * States which set TypedState::events are event-driven: instead of polling
+ * their transition() every tick, the state machine only evaluates it when
+ * the owner reports a relevant change with PostEvent() (e.g., a controller
+ * reaching its goal). This keeps the per-tick cost of idle or waiting
+ * machines to a bitmask test.
+ *
+ * States may also declare a timeout (TypedState::timeout) after which the
+ * state machine moves to another state. Timeouts are counted in calls to
+ * Run() by one TimerWheel shared by all of the machine's states, so
+ * subsystems don't need their own timers and checking for expiry costs the
+ * same no matter how many states have timeouts.
+ *
+ * States can be nested by giving AddState() a parent state. Entering a parent
+ * enters its initial substate (the first child added, unless changed with
+ * SetInitialState()), so the current state is always a leaf and all of its
+ * ancestors are active too. Each tick, run() is called on the active states
+ * from the outermost in, then their transitions are checked from the
+ * innermost out. A transition exits states up to the least common ancestor
+ * of the source and target, then enters states down to the target's leaf.
+ *
+ * The path from the root to every state is precomputed into one flat array,
+ * so each entry or exit sequence is a slice of it, and the least common
+ * ancestor of each (source, target) pair is computed the first time that
+ * transition is taken and cached. A transition therefore costs the same
+ * whether the machine is flat or nested.
+ *
+ * Every transition is recorded in a TransitionTrace, which another thread can
+ * drain to a log without slowing down Run().
+ *
+ * Save() copies the current state, the time spent in it, pending events, and
+ * the remaining time of the active states' timeouts into a Snapshot, and
+ * Restore() puts them back. A simulation can checkpoint a machine this way
+ * and fork variants from the checkpoint instead of replaying from the start.
+ *
+ * @tparam StateID Enum (or integral type) whose values are small,
+ *                 non-negative and densely packed.
+ */
+template <typename StateID>
+class TypedStateMachine {
+public:
+    using Transition = typename TypedState<StateID>::Transition;
+
+    /**
+     * The maximum nesting depth whose timeouts are saved in a Snapshot.
+     */
+    static constexpr int kMaxSnapshotDepth = 8;
+
+    /**
+     * A copy of a state machine's progress through its states. It's trivially
+     * copyable, so it can be serialized with memcpy().
+     */
+    struct Snapshot {
+        // ID of the innermost state, or TransitionRecord::kNoState
+        uint16_t state = TransitionRecord::kNoState;
+
+        // Bit i is set if the active state at depth i hasn't evaluated its
+        // transition since it was entered
+        uint8_t evaluateTransition = 0;
+
+        // Number of calls to Run() since the innermost state was entered
+        uint32_t ticksInState = 0;
+
+        // Events posted since the last call to Run()
+        uint32_t pendingEvents = 0;
+
+        // Calls to Run() left until each active state times out, outermost
+        // first, or 0 if the state has no timeout
+        std::array<uint32_t, kMaxSnapshotDepth> timeouts{};
+    };
+
+    /**
+     * Constructs a TypedStateMachine.
+     *
+     * @param period The period at which Run() is called. State timeouts are
+     *               converted to a number of calls to Run() with this.
+     */
+    explicit TypedStateMachine(units::second_t period = 20_ms)
+        : m_period{period} {}
+
+    // The states' callables usually capture the owner's "this" pointer
+    TypedStateMachine(const TypedStateMachine&) = delete;
+    TypedStateMachine& operator=(const TypedStateMachine&) = delete;
+
+    /**
+     * Adds a top-level state to the transition table.
+     *
+     * Ownership of 'state' will be transferred to this class. Adding a state
+     * with an ID that was already added replaces it.
+     *
+     * A timeout state is usually added after the states which time out to it,
+     * so one that was never added is reported when the transition tables are
+     * built on the first SetState() or Run() after adding states.
+     *
+     * @param id    ID of the state.
+     * @param state The state.
+     */
+    void AddState(StateID id, TypedState<StateID>&& state) {
+        size_t index = ToIndex(id);
+        if (index >= m_states.size()) {
+            m_states.resize(index + 1);
+            m_timers.Reserve(index + 1);
+        }
+
+        auto& slot = m_states[index];
+        slot.state = std::move(state);
+        slot.parent = kNoState;
+        slot.registered = true;
+        if (slot.state.timeout > 0_s) {
+            double periods = slot.state.timeout / m_period;
+            slot.timeoutTicks = static_cast<uint64_t>(std::ceil(periods));
+        } else {
+            slot.timeoutTicks = 0;
+        }
+
+        m_hierarchyChanged = true;
+    }
+
+    /**
+     * Adds a state nested inside another state.
+     *
+     * The parent must be added first. If the parent has no initial substate
+     * yet, this state becomes it.
+     *
+     * @param id     ID of the state.
+     * @param state  The state.
+     * @param parent ID of the parent state.
+     */
+    void AddState(StateID id, TypedState<StateID>&& state, StateID parent) {
+        AddState(id, std::move(state));
+
+        size_t parentIndex = ToIndex(parent);
+        if (parentIndex >= m_states.size() ||
+            !m_states[parentIndex].registered) {
+            fmt::print("[{}] is not a known state\n", parentIndex);
+            return;
+        }
+
+        m_states[ToIndex(id)].parent = parentIndex;
+        if (m_states[parentIndex].initialState == kNoState) {
+            m_states[parentIndex].initialState = ToIndex(id);
+        }
+    }
+
+    /**
+     * Sets which substate is entered when the parent state is entered.
+     *
+     * @param parent ID of the parent state.
+     * @param child  ID of the substate, which must be a child of parent.
+     */
+    void SetInitialState(StateID parent, StateID child) {
+        m_states[ToIndex(parent)].initialState = ToIndex(child);
+        m_hierarchyChanged = true;
+    }
+
+    /**
+     * Moves the state machine to the given state.
+     *
+     * If the next state is found, exit() is called for the active states that
+     * aren't ancestors of the next state, then entry() is called for the next
+     * state, its ancestors that weren't active, and its initial substates.
+     *
+     * The first call after states are added builds the transition tables.
+     *
+     * @param id ID of the next state.
+     * @return True if the next state was found and false otherwise.
+     */
+    bool SetState(StateID id) { return TakeTransition(m_currentState, id); }
+
+    /**
+     * Notifies the state machine that the given events occurred.
+     *
+     * Events are consumed by the next call to Run(). If no active state is
+     * subscribed to any of them, they're discarded.
+     *
+     * @param events Bitmask of events.
+     */
+    void PostEvent(uint32_t events) { m_pendingEvents |= events; }
+
+    /**
+     * Returns ID of current (innermost) state or an empty value if no state
+     * has been set.
+     */
+    std::optional<StateID> GetState() const {
+        if (m_currentState != kNoState) {
+            return static_cast<StateID>(m_currentState);
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    /**
+     * Returns the time since the current (innermost) state was entered,
+     * counted in calls to Run().
+     */
+    units::second_t GetTimeInState() const {
+        return static_cast<double>(m_timers.GetTick() - m_enteredTick) *
+               m_period;
+    }
+
+    /**
+     * Returns a snapshot of the state machine's progress.
+     */
+    Snapshot Save() const {
+        Snapshot snapshot;
+        snapshot.pendingEvents = m_pendingEvents;
+        if (m_currentState == kNoState) {
+            return snapshot;
+        }
+
+        snapshot.state = ToTraceID(m_currentState);
+        snapshot.ticksInState =
+            static_cast<uint32_t>(m_timers.GetTick() - m_enteredTick);
+
+        int depth = 0;
+        for (size_t index = m_currentState; index != kNoState;
+             index = m_states[index].parent) {
+            ++depth;
+        }
+
+        // Walk from the innermost state out, filling in from the deepest depth
+        for (size_t index = m_currentState; index != kNoState;
+             index = m_states[index].parent) {
+            --depth;
+            if (depth >= kMaxSnapshotDepth) {
+                continue;
+            }
+
+            snapshot.timeouts[depth] =
+                static_cast<uint32_t>(m_timers.GetRemaining(index));
+            if (m_states[index].evaluateTransition) {
+                snapshot.evaluateTransition |= 1 << depth;
+            }
+        }
+
+        return snapshot;
+    }
+
+    /**
+     * Restores progress saved by Save().
+     *
+     * The current state is replaced without calling any exit() or entry(), so
+     * the owner should restore any data those would have set. The snapshot
+     * must come from a machine with the same states.
+     *
+     * @param snapshot The snapshot.
+     * @return True if the snapshot's state was found and false otherwise.
+     */
+    bool Restore(const Snapshot& snapshot) {
+        size_t leaf = snapshot.state == TransitionRecord::kNoState
+                          ? kNoState
+                          : snapshot.state;
+        if (leaf != kNoState &&
+            (leaf >= m_states.size() || !m_states[leaf].registered)) {
+            return false;
+        }
+
+        if (m_hierarchyChanged) {
+            BuildHierarchy();
+        }
+
+        // Only innermost states can be current
+        if (leaf != kNoState && m_states[leaf].leaf != leaf) {
+            return false;
+        }
+
+        for (size_t index = m_currentState; index != kNoState;
+             index = m_states[index].parent) {
+            m_timers.Cancel(index);
+        }
+
+        size_t previousState = m_currentState;
+        m_currentState = leaf;
+        m_pendingEvents = snapshot.pendingEvents;
+        m_enteredTick = m_timers.GetTick() - snapshot.ticksInState;
+        m_trace.Record(wpi::Now(), static_cast<uint32_t>(m_timers.GetTick()),
+                       ToTraceID(previousState), snapshot.state);
+
+        if (leaf == kNoState) {
+            return true;
+        }
+
+        const auto& current = m_states[leaf];
+        for (int i = 0; i <= current.depth; ++i) {
+            auto& slot = m_states[m_paths[current.pathOffset + i]];
+            if (i < kMaxSnapshotDepth) {
+                if (snapshot.timeouts[i] > 0) {
+                    m_timers.Schedule(m_paths[current.pathOffset + i],
+                                      snapshot.timeouts[i]);
+                }
+                slot.evaluateTransition =
+                    (snapshot.evaluateTransition & (1 << i)) != 0;
+            } else {
+                slot.evaluateTransition = false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Returns true if the given state is the current state or one of its
+     * ancestors.
+     *
+     * @param id ID of the state.
+     */
+    bool IsInState(StateID id) const {
+        for (size_t index = m_currentState; index != kNoState;
+             index = m_states[index].parent) {
+            if (index == ToIndex(id)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Returns the record of this state machine's transitions.
+     */
+    TransitionTrace& GetTrace() { return m_trace; }
+
+    /**
+     * Runs the active states, then moves to the timeout state of the
+     * outermost state whose timeout elapsed, or else to the state returned by
+     * the innermost transition() that returns one.
+     *
+     * For event-driven states, transition() is skipped unless one of the
+     * state's events was posted since the last call.
+     */
+    void Run() {
+        if (m_hierarchyChanged) {
+            BuildHierarchy();
+        }
+        if (m_currentState == kNoState) {
+            return;
+        }
+
+        const size_t leaf = m_currentState;
+        const size_t* path = &m_paths[m_states[leaf].pathOffset];
+        const int depth = m_states[leaf].depth;
+
+        for (int i = 0; i <= depth; ++i) {
+            m_states[path[i]].state.run();
+            if (m_currentState != leaf) {
+                // run() changed the state
+                m_pendingEvents = 0;
+                return;
+            }
+        }
+
+        // Only active states have timers scheduled
+        size_t timedOut = kNoState;
+        m_timers.Advance([&](size_t index) {
+            if (timedOut == kNoState ||
+                m_states[index].depth < m_states[timedOut].depth) {
+                timedOut = index;
+            }
+        });
+        if (timedOut != kNoState) {
+            m_pendingEvents = 0;
+            auto timeoutState = m_states[timedOut].state.timeoutState;
+            if (!TakeTransition(timedOut, timeoutState)) {
+                // Failed to find state matching the timeout state
+                fmt::print("[{}] is not a known state\n",
+                           ToIndex(timeoutState));
+            }
+            return;
+        }
+
+        uint32_t events = m_pendingEvents;
+        m_pendingEvents = 0;
+
+        for (int i = depth; i >= 0; --i) {
+            auto& slot = m_states[path[i]];
+
+            bool evaluate =
+                slot.evaluateTransition ||
+                slot.state.events == TypedState<StateID>::kPollEveryTick ||
+                (events & slot.state.events) != 0;
+            slot.evaluateTransition = false;
+            if (!evaluate) {
+                continue;
+            }
+
+            if (Transition nextState = slot.state.transition()) {
+                if (!TakeTransition(path[i], *nextState)) {
+                    // Failed to find state matching the returned ID
+                    fmt::print("[{}] is not a known state\n",
+                               ToIndex(*nextState));
+                }
+                return;
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kNoState = std::numeric_limits<size_t>::max();
+
+    // Marks a (source, target) pair whose least common ancestor isn't cached
+    static constexpr int16_t kUncached = std::numeric_limits<int16_t>::min();
+
+    struct Slot {
+        TypedState<StateID> state;
+        uint64_t timeoutTicks = 0;
+        size_t parent = kNoState;
+        size_t initialState = kNoState;
+        bool registered = false;
+
+        // Set on entry so the state's transition condition is checked once
+        bool evaluateTransition = false;
+
+        // Number of ancestors
+        int depth = 0;
+
+        // Index into m_paths of the path from the root to this state
+        size_t pathOffset = 0;
+
+        // The leaf entered when this state is entered
+        size_t leaf = kNoState;
+    };
+
+    units::second_t m_period;
+    std::vector<Slot> m_states;
+
+    // The innermost active state
+    size_t m_currentState = kNoState;
+
+    // Timers of the active states, identified by state index
+    TimerWheel m_timers;
+
+    uint32_t m_pendingEvents = 0;
+
+    // Value of m_timers.GetTick() when the current state was entered
+    uint64_t m_enteredTick = 0;
+
+    // The root-to-state path of every state, one after another
+    std::vector<size_t> m_paths;
+
+    /* For each (source, target) pair, the depth of the deepest state that's a
+     * proper ancestor of both, or -1 if there isn't one. States below it are
+     * exited and entered by the transition.
+     */
+    std::vector<int16_t> m_lcaDepths;
+
+    bool m_hierarchyChanged = true;
+
+    TransitionTrace m_trace;
+
+    static_assert(std::is_trivially_copyable_v<Snapshot>);
+
+    static constexpr size_t ToIndex(StateID id) {
+        return static_cast<size_t>(id);
+    }
+
+    static constexpr uint16_t ToTraceID(size_t index) {
+        return index == kNoState ? TransitionRecord::kNoState
+                                 : static_cast<uint16_t>(index);
+    }
+
+    /**
+     * Rebuilds the state paths, reports timeout states which were never
+     * added, and clears the cached ancestors. This is the only place the
+     * tables allocate.
+     */
+    void BuildHierarchy() {
+        size_t count = m_states.size();
+
+        m_paths.clear();
+        std::vector<size_t> ancestors;
+        for (size_t index = 0; index < count; ++index) {
+            auto& slot = m_states[index];
+            if (!slot.registered) {
+                continue;
+            }
+
+            // Walk to the root, stopping if the parents form a cycle
+            ancestors.clear();
+            for (size_t i = index; i != kNoState && ancestors.size() < count;
+                 i = m_states[i].parent) {
+                ancestors.emplace_back(i);
+            }
+
+            slot.depth = static_cast<int>(ancestors.size()) - 1;
+            slot.pathOffset = m_paths.size();
+            m_paths.insert(m_paths.end(), ancestors.rbegin(), ancestors.rend());
+
+            // Every timeout must lead somewhere, or the state would stay put
+            // once its timer expires
+            if (slot.timeoutTicks > 0) {
+                size_t timeoutIndex = ToIndex(slot.state.timeoutState);
+                if (timeoutIndex >= count ||
+                    !m_states[timeoutIndex].registered) {
+                    fmt::print("[{}] is not a known state\n", timeoutIndex);
+                }
+            }
+
+            // Follow initial substates down to a leaf
+            slot.leaf = index;
+            for (size_t i = 0; i < count; ++i) {
+                size_t child = m_states[slot.leaf].initialState;
+                if (child == kNoState || !m_states[child].registered ||
+                    m_states[child].parent != slot.leaf) {
+                    break;
+                }
+                slot.leaf = child;
+            }
+        }
+
+        m_lcaDepths.assign(count * count, kUncached);
+        m_hierarchyChanged = false;
+    }
+
+    /**
+     * Returns the depth of the deepest proper ancestor shared by the source
+     * and target states, or -1 if they share none.
+     */
+    int LcaDepth(size_t source, size_t target) {
+        auto& lcaDepth = m_lcaDepths[source * m_states.size() + target];
+        if (lcaDepth == kUncached) {
+            const auto& from = m_states[source];
+            const auto& to = m_states[target];
+
+            int common = 0;
+            int limit = std::min(from.depth, to.depth);
+            while (common < limit && m_paths[from.pathOffset + common] ==
+                                         m_paths[to.pathOffset + common]) {
+                ++common;
+            }
+            lcaDepth = static_cast<int16_t>(common - 1);
+        }
+        return lcaDepth;
+    }
+
+    /**
+     * Transitions from the given active state (or from no state) to the given
+     * state's leaf.
+     *
+     * @return True if the target state was found and false otherwise.
+     */
+    bool TakeTransition(size_t source, StateID id) {
+        size_t target = ToIndex(id);
+        if (target >= m_states.size() || !m_states[target].registered) {
+            return false;
+        }
+
+        if (m_hierarchyChanged) {
+            BuildHierarchy();
+        }
+
+        int lcaDepth = source == kNoState ? -1 : LcaDepth(source, target);
+
+        if (m_currentState != kNoState) {
+            const auto& current = m_states[m_currentState];
+            for (int i = current.depth; i > lcaDepth; --i) {
+                size_t index = m_paths[current.pathOffset + i];
+                m_timers.Cancel(index);
+                m_states[index].state.exit();
+            }
+        }
+
+        size_t previousState = m_currentState;
+        m_currentState = m_states[target].leaf;
+        m_enteredTick = m_timers.GetTick();
+        m_trace.Record(wpi::Now(), static_cast<uint32_t>(m_timers.GetTick()),
+                       ToTraceID(previousState), ToTraceID(m_currentState));
+
+        const auto& next = m_states[m_currentState];
+        for (int i = lcaDepth + 1; i <= next.depth; ++i) {
+            size_t index = m_paths[next.pathOffset + i];
+            auto& slot = m_states[index];
+            if (slot.timeoutTicks > 0) {
+                m_timers.Schedule(index, slot.timeoutTicks);
+            }
+
+            // The state's transition condition may already be true
+            slot.evaluateTransition = true;
+
+            slot.state.entry();
+        }
+
+        return true;
+    }
+};
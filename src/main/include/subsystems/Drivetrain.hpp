@@ -11,6 +11,7 @@
 #include <units/voltage.h>
 
 #include "CANEncoder.hpp"
+#include "StatusFrameBudget.hpp"
 #include "TalonSRXGroup.hpp"
 
 /**
@@ -28,6 +29,26 @@ public:
      */
     void Drive(double throttle, double turn, bool isQuickTurn = false);
 
+    /**
+     * Declares the drivetrain's Talons and the status frames it reads.
+     */
+    void AddStatusFrames(StatusFrameBudget& budget);
+
+    /**
+     * Reads the encoders once for this tick.
+     *
+     * This should be called at the start of each tick, before anything reads
+     * the encoders.
+     */
+    void SampleSensors();
+
+    /**
+     * Sends the motor outputs which changed this tick.
+     *
+     * This should be called at the end of each tick.
+     */
+    void FlushOutputs();
+
     /**
      * Sets encoder distances to 0.
      */
@@ -60,7 +81,11 @@ public:
     void SetSetpointsToMeasurements();
 
     /**
-     * Runs closed-loop position control on motors.
+     * Runs closed-loop position control on motors with the encoder samples
+     * extrapolated to now.
+     *
+     * No autonomous mode drives to a position yet, so nothing calls this and
+     * only the elevator's controller is latency compensated in practice.
      */
     void UpdateControllers();
 
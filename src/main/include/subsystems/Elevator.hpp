@@ -2,25 +2,30 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <atomic>
 #include <map>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include <ctre/phoenix/motorcontrol/can/WPI_TalonSRX.h>
-#include <frc/Solenoid.h>
 #include <frc/controller/ProfiledPIDController.h>
-#include <frc2/Timer.h>
+#include <frc/trajectory/TrapezoidProfile.h>
 #include <units/acceleration.h>
 #include <units/length.h>
 #include <units/velocity.h>
 #include <units/voltage.h>
+#include <wpi/StringRef.h>
 
+#include "BufferedSolenoid.hpp"
 #include "CANDigitalInput.hpp"
 #include "CANEncoder.hpp"
-#include "StateMachine.hpp"
+#include "StatusFrameBudget.hpp"
 #include "TalonSRXGroup.hpp"
+#include "TypedStateMachine.hpp"
 
 /**
  * Provides an interface for the robot's elevator
@@ -35,6 +40,40 @@ public:
         S_ROTATE_CW
     };
 
+    enum AutoStackState {
+        S_IDLE,
+
+        // Parent of every state below, so canceling is one transition
+        S_STACKING,
+        S_WAIT_INITIAL_HEIGHT,
+        S_SEEK_DROP_TOTES,
+        S_RELEASE,
+        S_SEEK_GROUND,
+        S_GRAB,
+        S_SEEK_HALF_TOTE,
+        S_INTAKE_IN
+    };
+
+    /**
+     * The auto-stacking state machine's progress and the data its states set,
+     * so simulations can checkpoint a stack and fork variants from it.
+     */
+    struct AutoStackSnapshot {
+        TypedStateMachine<AutoStackState>::Snapshot machine;
+        frc::TrapezoidProfile<units::inches>::State goal;
+        frc::TrapezoidProfile<units::inches>::State setpoint;
+        bool startAutoStacking = false;
+        bool lastAtGoal = false;
+        bool elevatorGrabbed = false;
+        bool intakeGrabbed = false;
+    };
+
+    // Events which can move the auto-stacking state machine
+    enum AutoStackEvent : uint32_t {
+        E_STACK_REQUESTED = 1 << 0,
+        E_GOAL_REACHED = 1 << 1
+    };
+
     static constexpr units::inch_t kGroundHeight = 0.0_in;
     static constexpr units::inch_t kToteHeight1 = 16.0_in;
     static constexpr units::inch_t kToteHeight2 = 28.76_in;
@@ -56,6 +95,23 @@ public:
 
     Elevator();
 
+    /**
+     * Looks up a preset height by name: ground, tote1 through tote5, step,
+     * garbagecan, autodrop, or max.
+     *
+     * @return The height, or std::nullopt if there's no such preset.
+     */
+    static std::optional<units::inch_t> FindHeightPreset(wpi::StringRef name);
+
+    /**
+     * Looks up an intake direction by name: stop, forward, reverse, ccw, or
+     * cw.
+     *
+     * @return The direction, or std::nullopt if there's no such direction.
+     */
+    static std::optional<IntakeMotorState> FindIntakeDirection(
+        wpi::StringRef name);
+
     // Actuates elevator tines in/out
     void ElevatorGrab(bool state);
     bool IsElevatorGrabbed() const;
@@ -85,6 +141,9 @@ public:
 
     // Sets setpoint for elevator PID controller
     void SetHeight(units::meter_t height);
+
+    // Returns the height from the last encoder sample extrapolated to now.
+    // The controller, goal selection, and AtGoal() all use this measurement.
     units::meter_t GetHeight();
 
     // Returns if controller is at goal
@@ -92,6 +151,17 @@ public:
 
     void ResetEncoders();
 
+    // Declares the elevator's Talons and the status frames it reads
+    void AddStatusFrames(StatusFrameBudget& budget);
+
+    // Reads the lift encoder and limit switch once for this tick. This should
+    // be called at the start of each tick, before anything reads them.
+    void SampleSensors();
+
+    // Sends the actuator commands which changed this tick. This should be
+    // called at the end of each tick.
+    void FlushOutputs();
+
     // Takes a string representing the name of the height
     void RaiseElevator(units::meter_t level);
 
@@ -99,12 +169,19 @@ public:
     bool IsStacking() const;
     void CancelStack();
 
+    // Saves and restores progress through auto-stacking
+    AutoStackSnapshot SaveAutoStack() const;
+    void RestoreAutoStack(const AutoStackSnapshot& snapshot);
+
+    // Returns the record of auto-stacking state transitions
+    TransitionTrace& GetAutoStackTrace();
+
     // Periodically update the tote auto stacking state
     void UpdateState();
 
 private:
-    frc::Solenoid m_elevatorGrabber{3};
-    frc::Solenoid m_containerGrabber{4};
+    BufferedSolenoid m_elevatorGrabber{3};
+    BufferedSolenoid m_containerGrabber{4};
 
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_liftLeftMotor{7};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_liftRightMotor{2};
@@ -114,18 +191,20 @@ private:
 
     // Intake
     IntakeMotorState m_intakeState = S_STOPPED;
-    frc::Solenoid m_intakeStower{1};
-    frc::Solenoid m_intakeGrabber{2};
+    BufferedSolenoid m_intakeStower{1};
+    BufferedSolenoid m_intakeGrabber{2};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_intakeLeftMotor{3};
     ctre::phoenix::motorcontrol::can::WPI_TalonSRX m_intakeRightMotor{6};
+    TalonSRXGroup m_intakeLeft{m_intakeLeftMotor};
+    TalonSRXGroup m_intakeRight{m_intakeRightMotor};
 
     frc::ProfiledPIDController<units::inches> m_controller{
         3.0, 0.0, 0.0, {kMaxVUp, kMaxAUp}};
     CANDigitalInput m_limitSwitch{m_liftLeftMotor};
     bool m_lastLimitSwitchValue = false;
+    bool m_lastAtGoal = false;
 
-    StateMachine m_autoStackSM{"AUTO_STACK"};
-    frc2::Timer m_grabTimer;
+    TypedStateMachine<AutoStackState> m_autoStackSM;
     bool m_startAutoStacking = false;
 
     /**
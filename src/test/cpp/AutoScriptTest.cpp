@@ -0,0 +1,99 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "AutoScript.hpp"
+#include "subsystems/Elevator.hpp"
+
+namespace {
+
+// Returns the error compiling the script, or an empty string if it compiled
+std::string CompileError(const char* source) {
+    try {
+        AutoScript script{"Test", source};
+    } catch (const std::invalid_argument& e) {
+        return e.what();
+    }
+    return "";
+}
+
+}  // namespace
+
+TEST(AutoScriptTest, CompilesCommands) {
+    AutoScript script{"Test",
+                      "# Comment\n"
+                      "\n"
+                      "drive 1.5 -0.3 0.25 quickturn  # trailing comment\n"
+                      "height tote4\n"
+                      "grab elevator\n"
+                      "release intake\n"
+                      "stow intake\n"
+                      "intake ccw\n"
+                      "wait 0.2\n"
+                      "wait goal"};
+    EXPECT_EQ(script.GetName(), "Test");
+
+    using Opcode = AutoScript::Opcode;
+    const auto& instructions = script.GetInstructions();
+    ASSERT_EQ(instructions.size(), 8u);
+
+    EXPECT_EQ(instructions[0].opcode, Opcode::kDrive);
+    EXPECT_EQ(instructions[0].operand, 1);
+    EXPECT_FLOAT_EQ(instructions[0].args[0], 1.5f);
+    EXPECT_FLOAT_EQ(instructions[0].args[1], -0.3f);
+    EXPECT_FLOAT_EQ(instructions[0].args[2], 0.25f);
+
+    EXPECT_EQ(instructions[1].opcode, Opcode::kSetHeight);
+    EXPECT_FLOAT_EQ(instructions[1].args[0],
+                    units::inch_t{Elevator::kToteHeight4}.to<float>());
+
+    EXPECT_EQ(instructions[2].opcode, Opcode::kElevatorGrab);
+    EXPECT_EQ(instructions[2].operand, 1);
+    EXPECT_EQ(instructions[3].opcode, Opcode::kIntakeGrab);
+    EXPECT_EQ(instructions[3].operand, 0);
+    EXPECT_EQ(instructions[4].opcode, Opcode::kStowIntake);
+    EXPECT_EQ(instructions[4].operand, 1);
+
+    EXPECT_EQ(instructions[5].opcode, Opcode::kSetIntakeDirection);
+    EXPECT_EQ(instructions[5].operand, Elevator::S_ROTATE_CCW);
+
+    EXPECT_EQ(instructions[6].opcode, Opcode::kWait);
+    EXPECT_FLOAT_EQ(instructions[6].args[0], 0.2f);
+    EXPECT_EQ(instructions[7].opcode, Opcode::kWaitForGoal);
+}
+
+TEST(AutoScriptTest, RejectsUnknownCommands) {
+    EXPECT_EQ(CompileError("wait 1\njump 2\n"),
+              "line 2: unknown command 'jump'");
+    EXPECT_EQ(CompileError("Drive 1 0 0"), "line 1: unknown command 'Drive'");
+}
+
+TEST(AutoScriptTest, RejectsMalformedLines) {
+    EXPECT_EQ(CompileError("drive 1 0"),
+              "line 1: wrong number of arguments to 'drive'");
+    EXPECT_EQ(CompileError("wait"),
+              "line 1: wrong number of arguments to 'wait'");
+    EXPECT_EQ(CompileError("grab elevator intake"),
+              "line 1: wrong number of arguments to 'grab'");
+    EXPECT_EQ(CompileError("drive 1 0 0 slowturn"),
+              "line 1: expected 'quickturn', got 'slowturn'");
+    EXPECT_EQ(CompileError("grab arm"),
+              "line 1: expected 'elevator' or 'intake', got 'arm'");
+    EXPECT_EQ(CompileError("stow elevator"),
+              "line 1: expected 'intake', got 'elevator'");
+    EXPECT_EQ(CompileError("height tote9"), "line 1: unknown height 'tote9'");
+    EXPECT_EQ(CompileError("intake sideways"),
+              "line 1: unknown intake direction 'sideways'");
+}
+
+TEST(AutoScriptTest, RejectsBadNumbers) {
+    EXPECT_EQ(CompileError("wait soon"), "line 1: 'soon' isn't a number");
+    EXPECT_EQ(CompileError("wait 1s"), "line 1: '1s' isn't a number");
+    EXPECT_EQ(CompileError("wait nan"), "line 1: 'nan' isn't a number");
+    EXPECT_NE(CompileError("wait 20"), "");
+    EXPECT_NE(CompileError("drive 1 1.5 0"), "");
+    EXPECT_NE(CompileError("drive -1 0 0"), "");
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <cmath>
+#include <stdexcept>
+
+#include <frc/simulation/SimHooks.h>
+#include <gtest/gtest.h>
+
+#include "AutoSim.hpp"
+
+namespace {
+
+class AutoSimTest : public testing::Test {
+protected:
+    // The simulation steps time itself
+    void SetUp() override { frc::sim::PauseTiming(); }
+
+    void TearDown() override { frc::sim::ResumeTiming(); }
+};
+
+}  // namespace
+
+TEST_F(AutoSimTest, DriveForward) {
+    autosim::PlantParameters parameters;
+    auto result = autosim::Run("DriveForward", parameters);
+
+    // The mode drives at 40% for 2.5 s, then returns
+    EXPECT_EQ(result.mode, "DriveForward");
+    EXPECT_TRUE(result.finished);
+    EXPECT_NEAR(result.finishTime.to<double>(), 2.5,
+                2.0 * autosim::kDt.to<double>());
+
+    // Without noise, both sides travel the same distance, which is 40% of the
+    // free speed for 2.5 s since the lag lost speeding up is made up coasting
+    double expected = 0.4 * parameters.leftDriveFreeSpeed * 2.5;
+    double left = result.leftDistance.to<double>();
+    double right = result.rightDistance.to<double>();
+    EXPECT_NEAR(std::abs(left), expected, 0.05 * expected);
+    EXPECT_NEAR(std::abs(right), std::abs(left), 0.5);
+    EXPECT_NEAR(result.elevatorHeight.to<double>(), 0.0, 0.5);
+}
+
+TEST_F(AutoSimTest, RejectsUnknownMode) {
+    EXPECT_THROW(autosim::Run("NoSuchMode", autosim::PlantParameters{}),
+                 std::invalid_argument);
+}
@@ -0,0 +1,212 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <stddef.h>
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ButtonBindings.hpp"
+#include "JoystickSnapshot.hpp"
+
+namespace {
+
+using Action = ButtonBindings::Action;
+
+// Returns the error compiling the bindings, or an empty string if they
+// compiled
+std::string CompileError(const char* json) {
+    try {
+        ButtonBindings bindings{json};
+    } catch (const std::invalid_argument& e) {
+        return e.what();
+    }
+    return "";
+}
+
+// Joysticks on ports 0 through 2 which are changed one tick at a time
+class Sticks {
+public:
+    std::array<JoystickSnapshot, 3> sticks;
+
+    explicit Sticks(ButtonBindings& bindings) : m_bindings{bindings} {
+        m_bindings.Prime({&sticks[0], &sticks[1], &sticks[2]});
+    }
+
+    // Finds the changes since the last tick, then returns the actions of the
+    // bindings that fired
+    std::vector<Action> Tick() {
+        for (size_t i = 0; i < sticks.size(); ++i) {
+            sticks[i].FindChanges(m_last[i]);
+        }
+        m_last = sticks;
+
+        std::vector<Action> actions;
+        m_bindings.Evaluate(
+            {&sticks[0], &sticks[1], &sticks[2]},
+            [&](const auto& binding) { actions.emplace_back(binding.action); });
+        return actions;
+    }
+
+private:
+    ButtonBindings& m_bindings;
+    std::array<JoystickSnapshot, 3> m_last;
+};
+
+}  // namespace
+
+TEST(ButtonBindingsTest, RejectsBadJSON) {
+    EXPECT_THROW(ButtonBindings{"{"}, std::invalid_argument);
+    EXPECT_THROW(ButtonBindings{"[]"}, std::invalid_argument);
+    EXPECT_THROW(ButtonBindings{R"({"bindings": {}})"}, std::invalid_argument);
+    EXPECT_THROW(ButtonBindings{R"({"bindings": [1]})"},
+                 std::invalid_argument);
+
+    ButtonBindings empty{R"({"bindings": []})"};
+    EXPECT_EQ(empty.size(), 0u);
+}
+
+TEST(ButtonBindingsTest, RejectsBadBindings) {
+    EXPECT_EQ(CompileError(R"({"bindings": [
+                  {"stick": 0, "button": 1, "action": "stackTotes"},
+                  {"stick": 1, "button": 1, "action": "nope"}]})"),
+              "binding 1: unknown action 'nope'");
+    EXPECT_EQ(CompileError(R"({"bindings": [{"stick": 6, "button": 1,
+                  "action": "stackTotes"}]})"),
+              "binding 0: \"stick\" is 6, not between 0 and 5");
+    EXPECT_EQ(CompileError(R"({"bindings": [{"stick": 0, "button": 33,
+                  "action": "stackTotes"}]})"),
+              "binding 0: \"button\" is 33, not between 1 and 32");
+    EXPECT_EQ(CompileError(R"({"bindings": [{"stick": 0, "pov": 30,
+                  "action": "stackTotes"}]})"),
+              "binding 0: POV angle 30 isn't -1 or a multiple of 45 under 360");
+    EXPECT_EQ(CompileError(R"({"bindings": [{"stick": 0, "button": 1,
+                  "pov": 0, "action": "stackTotes"}]})"),
+              "binding 0: expected exactly one of \"button\", \"pov\", or "
+              "\"axis\"");
+    EXPECT_EQ(CompileError(R"({"bindings": [{"stick": 0, "button": 1,
+                  "on": "hold", "action": "stackTotes"}]})"),
+              "binding 0: expected \"on\" to be \"press\" or \"release\", got "
+              "\"hold\"");
+    EXPECT_EQ(CompileError(R"({"bindings": [{"stick": 0, "axis": 1,
+                  "action": "stackTotes"}]})"),
+              "binding 0: expected exactly one of \"above\" or \"below\"");
+    EXPECT_EQ(CompileError(R"({"bindings": [{"stick": 0, "button": 1,
+                  "action": "height", "height": "tote9"}]})"),
+              "binding 0: unknown height 'tote9'");
+
+    // The intake follows the joysticks every tick instead of bindings
+    EXPECT_EQ(CompileError(R"({"bindings": [{"stick": 0, "pov": 0,
+                  "action": "intake", "direction": "forward"}]})"),
+              "binding 0: unknown action 'intake'");
+}
+
+TEST(ButtonBindingsTest, FiresOnButtonEdges) {
+    ButtonBindings bindings{R"({"bindings": [
+        {"stick": 0, "button": 3, "action": "stackTotes"},
+        {"stick": 0, "button": 3, "on": "release",
+         "action": "toggleManualMode"}]})"};
+    ASSERT_EQ(bindings.size(), 2u);
+    Sticks sticks{bindings};
+
+    sticks.sticks[0].buttons = 1 << 2;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kStackTotes});
+
+    // Holding the button doesn't fire again
+    EXPECT_TRUE(sticks.Tick().empty());
+
+    sticks.sticks[0].buttons = 0;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kToggleManualMode});
+    EXPECT_TRUE(sticks.Tick().empty());
+}
+
+TEST(ButtonBindingsTest, FiresOnPOVChanges) {
+    ButtonBindings bindings{R"({"bindings": [
+        {"stick": 0, "pov": 90, "action": "stackTotes"},
+        {"stick": 0, "pov": -1, "action": "toggleManualMode"}]})"};
+    Sticks sticks{bindings};
+
+    sticks.sticks[0].pov = 90;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kStackTotes});
+    EXPECT_TRUE(sticks.Tick().empty());
+
+    // An unbound angle fires nothing, and coming back to 90 fires again
+    sticks.sticks[0].pov = 135;
+    EXPECT_TRUE(sticks.Tick().empty());
+    sticks.sticks[0].pov = 90;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kStackTotes});
+
+    // Releasing the hat fires the centered binding
+    sticks.sticks[0].pov = -1;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kToggleManualMode});
+    EXPECT_TRUE(sticks.Tick().empty());
+}
+
+TEST(ButtonBindingsTest, SeparatesSticks) {
+    ButtonBindings bindings{R"({"bindings": [
+        {"stick": 2, "button": 1, "action": "toggleIntakeGrab"},
+        {"stick": 1, "button": 1, "action": "toggleElevatorGrab"},
+        {"stick": 5, "button": 1, "action": "stackTotes"}]})"};
+    Sticks sticks{bindings};
+
+    sticks.sticks[2].buttons = 1;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kToggleIntakeGrab});
+
+    // Actions run in order of port
+    sticks.sticks[1].buttons = 1;
+    sticks.sticks[2].buttons = 0;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kToggleElevatorGrab});
+    sticks.sticks[1].buttons = 0;
+    EXPECT_TRUE(sticks.Tick().empty());
+
+    sticks.sticks[1].buttons = 1;
+    sticks.sticks[2].buttons = 1;
+    EXPECT_EQ(sticks.Tick(), (std::vector{Action::kToggleElevatorGrab,
+                                          Action::kToggleIntakeGrab}));
+
+    // Port 0 has no bindings, and port 5 isn't passed in
+    sticks.sticks[0].buttons = 1;
+    EXPECT_TRUE(sticks.Tick().empty());
+}
+
+TEST(ButtonBindingsTest, FiresWhenAxisCrossesThreshold) {
+    ButtonBindings bindings{R"({"bindings": [
+        {"stick": 0, "axis": 2, "above": 0.5, "action": "stackTotes"},
+        {"stick": 0, "axis": 2, "below": -0.5,
+         "action": "toggleManualMode"}]})"};
+
+    // An axis already past its threshold when primed doesn't fire until it
+    // comes back
+    Sticks sticks{bindings};
+    sticks.sticks[0].axes[2] = 0.9f;
+    bindings.Prime({&sticks.sticks[0]});
+    EXPECT_TRUE(sticks.Tick().empty());
+
+    sticks.sticks[0].axes[2] = 0.95f;
+    EXPECT_TRUE(sticks.Tick().empty());
+    sticks.sticks[0].axes[2] = 0.f;
+    EXPECT_TRUE(sticks.Tick().empty());
+    sticks.sticks[0].axes[2] = 0.6f;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kStackTotes});
+
+    sticks.sticks[0].axes[2] = -0.6f;
+    EXPECT_EQ(sticks.Tick(), std::vector{Action::kToggleManualMode});
+}
+
+TEST(ButtonBindingsTest, LoadsHeights) {
+    ButtonBindings bindings{R"({"bindings": [
+        {"stick": 0, "button": 1, "action": "height", "height": "tote4"}]})"};
+    Sticks sticks{bindings};
+
+    std::vector<float> heights;
+    sticks.sticks[0].buttons = 1;
+    sticks.sticks[0].FindChanges(JoystickSnapshot{});
+    bindings.Evaluate({&sticks.sticks[0]}, [&](const auto& binding) {
+        heights.emplace_back(binding.height);
+    });
+    ASSERT_EQ(heights.size(), 1u);
+    EXPECT_GT(heights[0], 0.f);
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <stdint.h>
+
+#include <frc/simulation/SimDeviceSim.h>
+#include <gtest/gtest.h>
+#include <hal/SimDevice.h>
+
+#include "subsystems/Elevator.hpp"
+
+namespace {
+
+// The ticks any stage of a stack is allowed to take
+constexpr int kMaxTicks = 500;
+
+class ElevatorTest : public testing::Test {
+protected:
+    Elevator elevator;
+    hal::SimDouble liftDistance =
+        frc::sim::SimDeviceSim{"CANEncoder[7]"}.GetDouble("distance");
+
+    // Runs one tick with a lift that follows the motion profile exactly
+    void Step() {
+        liftDistance.Set(
+            elevator.SaveAutoStack().setpoint.position.to<double>());
+        elevator.SampleSensors();
+        elevator.UpdateState();
+        elevator.FlushOutputs();
+    }
+
+    // Steps until the auto-stack enters the state and returns the number of
+    // ticks that took, or 0 if it didn't within kMaxTicks
+    int StepUntil(Elevator::AutoStackState state) {
+        for (int ticks = 1; ticks <= kMaxTicks; ++ticks) {
+            Step();
+            if (GetState() == state) {
+                return ticks;
+            }
+        }
+        return 0;
+    }
+
+    uint16_t GetState() const { return elevator.SaveAutoStack().machine.state; }
+};
+
+}  // namespace
+
+TEST_F(ElevatorTest, RestoresMidStack) {
+    elevator.StackTotes();
+    ASSERT_GT(StepUntil(Elevator::S_RELEASE), 0);
+    Step();
+    Step();
+
+    // S_RELEASE is a substate of S_STACKING, so its timeout is at depth 1
+    auto checkpoint = elevator.SaveAutoStack();
+    uint32_t remaining = checkpoint.machine.timeouts[1];
+    ASSERT_GT(remaining, 0u);
+    EXPECT_FALSE(checkpoint.elevatorGrabbed);
+
+    // Let the original run time out and move on
+    int ticksToSeekGround = StepUntil(Elevator::S_SEEK_GROUND);
+    ASSERT_GT(ticksToSeekGround, 0);
+    ASSERT_GT(StepUntil(Elevator::S_GRAB), 0);
+    EXPECT_TRUE(elevator.IsElevatorGrabbed());
+
+    elevator.RestoreAutoStack(checkpoint);
+    auto restored = elevator.SaveAutoStack();
+    EXPECT_EQ(restored.machine.state, checkpoint.machine.state);
+    EXPECT_EQ(restored.machine.ticksInState, checkpoint.machine.ticksInState);
+    EXPECT_EQ(restored.machine.timeouts, checkpoint.machine.timeouts);
+    EXPECT_EQ(restored.goal.position.to<double>(),
+              checkpoint.goal.position.to<double>());
+    EXPECT_EQ(restored.setpoint.position.to<double>(),
+              checkpoint.setpoint.position.to<double>());
+    EXPECT_TRUE(elevator.IsStacking());
+    EXPECT_FALSE(elevator.IsElevatorGrabbed());
+
+    // The restored run times out after the same number of ticks
+    EXPECT_EQ(StepUntil(Elevator::S_SEEK_GROUND), ticksToSeekGround);
+}
+
+TEST_F(ElevatorTest, RestoresIdle) {
+    auto idle = elevator.SaveAutoStack();
+
+    elevator.StackTotes();
+    ASSERT_GT(StepUntil(Elevator::S_SEEK_DROP_TOTES), 0);
+    EXPECT_TRUE(elevator.IsStacking());
+
+    elevator.RestoreAutoStack(idle);
+    EXPECT_FALSE(elevator.IsStacking());
+    EXPECT_EQ(GetState(), Elevator::S_IDLE);
+}
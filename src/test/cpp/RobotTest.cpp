@@ -0,0 +1,103 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <gtest/gtest.h>
+
+#include "Robot.hpp"
+
+namespace {
+
+// Finds each joystick's changes since the last snapshot, then runs a tick of
+// teleop with them
+void RunTeleop(Robot& robot, Robot::Inputs& inputs, Robot::Inputs& last) {
+    inputs.driveStick1.FindChanges(last.driveStick1);
+    inputs.driveStick2.FindChanges(last.driveStick2);
+    inputs.appendageStick.FindChanges(last.appendageStick);
+    robot.RunTeleop(inputs);
+    last = inputs;
+}
+
+}  // namespace
+
+TEST(RobotTest, IntakeStopsByDefault) {
+    Robot::Inputs inputs;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_STOPPED);
+
+    // Diagonals and the other sticks' triggers don't run the intake
+    inputs.driveStick2.pov = 45;
+    inputs.appendageStick.pov = 315;
+    inputs.driveStick1.buttons = 1;
+    inputs.appendageStick.buttons = 1;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_STOPPED);
+}
+
+TEST(RobotTest, IntakeFollowsEitherPOV) {
+    Robot::Inputs inputs;
+
+    inputs.driveStick2.pov = 0;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_FORWARD);
+    inputs.driveStick2.pov = 90;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_ROTATE_CCW);
+    inputs.driveStick2.pov = 180;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_REVERSE);
+    inputs.driveStick2.pov = 270;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_ROTATE_CW);
+
+    inputs.driveStick2.pov = -1;
+    inputs.appendageStick.pov = 0;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_FORWARD);
+    inputs.appendageStick.pov = 270;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_ROTATE_CW);
+}
+
+TEST(RobotTest, IntakeDirectionsHavePriority) {
+    Robot::Inputs inputs;
+
+    // Forward beats counterclockwise, which beats reverse, which beats
+    // clockwise, no matter which stick each comes from
+    inputs.driveStick2.pov = 90;
+    inputs.appendageStick.pov = 0;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_FORWARD);
+
+    inputs.driveStick2.pov = 180;
+    inputs.appendageStick.pov = 90;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_ROTATE_CCW);
+
+    // The second drive stick's trigger reverses unless the hats say otherwise
+    inputs.driveStick2.pov = 270;
+    inputs.appendageStick.pov = -1;
+    inputs.driveStick2.buttons = 1;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_REVERSE);
+
+    inputs.driveStick2.pov = 90;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_ROTATE_CCW);
+
+    inputs.driveStick2.buttons = 0;
+    inputs.driveStick2.pov = 270;
+    EXPECT_EQ(Robot::GetIntakeDirection(inputs), Elevator::S_ROTATE_CW);
+}
+
+TEST(RobotTest, TeleopTogglesTinesOncePerPress) {
+    Robot robot;
+    Robot::Inputs inputs;
+    Robot::Inputs last;
+    bool grabbed = robot.elevator.IsElevatorGrabbed();
+
+    // The appendage stick's trigger toggles the tines when it's pressed
+    inputs.appendageStick.buttons = 1;
+    RunTeleop(robot, inputs, last);
+    EXPECT_EQ(robot.elevator.IsElevatorGrabbed(), !grabbed);
+
+    // Holding it doesn't toggle them again
+    RunTeleop(robot, inputs, last);
+    RunTeleop(robot, inputs, last);
+    EXPECT_EQ(robot.elevator.IsElevatorGrabbed(), !grabbed);
+
+    // Nor does releasing it
+    inputs.appendageStick.buttons = 0;
+    RunTeleop(robot, inputs, last);
+    EXPECT_EQ(robot.elevator.IsElevatorGrabbed(), !grabbed);
+
+    inputs.appendageStick.buttons = 1;
+    RunTeleop(robot, inputs, last);
+    EXPECT_EQ(robot.elevator.IsElevatorGrabbed(), grabbed);
+}
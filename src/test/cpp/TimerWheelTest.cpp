@@ -0,0 +1,113 @@
+// Copyright (c) 2021 FRC Team 3512. All Rights Reserved.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TimerWheel.hpp"
+
+namespace {
+
+// Advances the wheel until the timer expires and returns the number of ticks
+// that took, or 0 if it didn't expire within the limit
+uint64_t TicksUntilExpiry(TimerWheel& wheel, size_t id, uint64_t limit) {
+    for (uint64_t ticks = 1; ticks <= limit; ++ticks) {
+        bool expired = false;
+        wheel.Advance([&](size_t expiredID) {
+            if (expiredID == id) {
+                expired = true;
+            }
+        });
+        if (expired) {
+            return ticks;
+        }
+    }
+    return 0;
+}
+
+}  // namespace
+
+TEST(TimerWheelTest, ExpiresAfterDelay) {
+    TimerWheel wheel{1};
+    wheel.Schedule(0, 5);
+    EXPECT_TRUE(wheel.IsScheduled(0));
+    EXPECT_EQ(wheel.GetRemaining(0), 5u);
+    EXPECT_EQ(TicksUntilExpiry(wheel, 0, 100), 5u);
+    EXPECT_FALSE(wheel.IsScheduled(0));
+    EXPECT_EQ(wheel.GetRemaining(0), 0u);
+}
+
+TEST(TimerWheelTest, CascadesFromHigherLevels) {
+    // Delays that land in each level, and ones right at the level boundaries
+    const std::vector<uint64_t> delays{
+        1,
+        TimerWheel::kSlots - 1,
+        TimerWheel::kSlots,
+        TimerWheel::kSlots + 1,
+        3 * TimerWheel::kSlots + 5,
+        TimerWheel::kSlots * TimerWheel::kSlots - 1,
+        TimerWheel::kSlots * TimerWheel::kSlots,
+        5000,
+        TimerWheel::kMaxDelay};
+
+    for (uint64_t start : {uint64_t{0}, uint64_t{37}}) {
+        for (uint64_t delay : delays) {
+            TimerWheel wheel{1};
+
+            // Start partway through a revolution so expiries aren't aligned
+            // with the slots
+            for (uint64_t i = 0; i < start; ++i) {
+                wheel.Advance([](size_t) {});
+            }
+
+            wheel.Schedule(0, delay);
+            EXPECT_EQ(TicksUntilExpiry(wheel, 0, TimerWheel::kMaxDelay + 1),
+                      delay)
+                << "delay " << delay << " starting at tick " << start;
+        }
+    }
+}
+
+TEST(TimerWheelTest, RemainingCountsDownAcrossCascades) {
+    TimerWheel wheel{1};
+    wheel.Schedule(0, 200);
+    for (uint64_t ticks = 1; ticks < 200; ++ticks) {
+        wheel.Advance([](size_t) {});
+        ASSERT_EQ(wheel.GetRemaining(0), 200 - ticks);
+    }
+}
+
+TEST(TimerWheelTest, ClampsDelays) {
+    TimerWheel wheel{2};
+
+    wheel.Schedule(0, 0);
+    EXPECT_EQ(wheel.GetRemaining(0), 1u);
+
+    wheel.Schedule(1, TimerWheel::kMaxDelay + 1000);
+    EXPECT_EQ(wheel.GetRemaining(1), TimerWheel::kMaxDelay);
+    EXPECT_EQ(TicksUntilExpiry(wheel, 1, TimerWheel::kMaxDelay + 1),
+              TimerWheel::kMaxDelay);
+}
+
+TEST(TimerWheelTest, CancelAndReschedule) {
+    TimerWheel wheel{3};
+    wheel.Schedule(0, 10);
+    wheel.Schedule(1, 10);
+    wheel.Schedule(2, 10);
+
+    wheel.Cancel(1);
+    EXPECT_FALSE(wheel.IsScheduled(1));
+
+    // Rescheduling replaces the old expiry
+    wheel.Schedule(2, 100);
+
+    std::vector<size_t> expired;
+    for (int i = 0; i < 10; ++i) {
+        wheel.Advance([&](size_t id) { expired.emplace_back(id); });
+    }
+    EXPECT_EQ(expired, std::vector<size_t>{0});
+    EXPECT_EQ(wheel.GetRemaining(2), 90u);
+}